@@ -1,13 +1,3 @@
 #version 330 core
-out vec4 FragColor;
-
-in vec3 ourColor;
-in vec2 TexCoord;
-
-uniform sampler2D texture1;
-uniform sampler2D texture2;
-
-void main()
-{
-    FragColor = mix(texture(texture1, TexCoord), texture(texture2, vec2(TexCoord.x, TexCoord.y)), 0.1);
-}
\ No newline at end of file
+#define FIXED_OPACITY 0.1
+#include "../common/mix_textures.glsl"
\ No newline at end of file
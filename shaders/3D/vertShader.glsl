@@ -7,8 +7,7 @@ out vec3 ourColor;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "../common/frame_uniforms.glsl"
 
 void main()
 {
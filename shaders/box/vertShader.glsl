@@ -5,8 +5,7 @@ layout (location = 1) in vec2 aTexCoord;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "../common/frame_uniforms.glsl"
 
 void main()
 {
@@ -0,0 +1,9 @@
+// per-frame globals shared by every program, bound to binding point 0 (see src/frame_uniforms.h);
+// the std140 layout must match FrameUniformData
+layout (std140) uniform Frame
+{
+    mat4  projection;
+    mat4  view;
+    vec2  resolution; // framebuffer size in pixels
+    float time;       // seconds since startup
+};
\ No newline at end of file
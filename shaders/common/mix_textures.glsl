@@ -0,0 +1,18 @@
+// blends two textures; define FIXED_OPACITY to bake the blend factor in instead of reading the opacity uniform
+out vec4 FragColor;
+
+in vec3 ourColor;
+in vec2 TexCoord;
+
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+#ifdef FIXED_OPACITY
+const float opacity = FIXED_OPACITY;
+#else
+uniform float opacity;
+#endif
+
+void main()
+{
+    FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), opacity);
+}
\ No newline at end of file
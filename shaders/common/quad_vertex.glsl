@@ -0,0 +1,2 @@
+// vertex layout of the unit quads the sprite and text renderers draw
+layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
\ No newline at end of file
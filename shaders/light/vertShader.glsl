@@ -8,8 +8,7 @@ out vec3 Normal;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "../common/frame_uniforms.glsl"
 uniform mat3 normalMatrix; // ߾
 
 void main()
@@ -1,11 +1,30 @@
 #version 330 core
+// permutations: see vertShader.glsl
 in vec2 TexCoords;
-out vec4 color;
-
+#ifdef ARRAY_TEXTURE
+flat in float Layer;
+uniform sampler2DArray image;
+#else
 uniform sampler2D image;
+#endif
+#ifdef TINT
+#ifdef INSTANCED
+in vec3 SpriteColor;
+#else
 uniform vec3 spriteColor;
+#define SpriteColor spriteColor
+#endif
+#endif
+out vec4 color;
 
 void main()
 {
-    color = vec4(spriteColor, 1.0) * texture(image, TexCoords);
+#ifdef ARRAY_TEXTURE
+    color = texture(image, vec3(TexCoords, Layer));
+#else
+    color = texture(image, TexCoords);
+#endif
+#ifdef TINT
+    color *= vec4(SpriteColor, 1.0);
+#endif
 }
\ No newline at end of file
@@ -1,13 +1,60 @@
 #version 330 core
-layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+// permutations: INSTANCED (per-instance attributes instead of uniforms), ATLAS (sample a
+// sub-rect of the texture), TINT (multiply by the sprite color), ARRAY_TEXTURE (sample a
+// layer of a sampler2DArray)
+#include "../common/quad_vertex.glsl"
+#ifdef INSTANCED
+layout (location = 1) in vec4 instanceRow0;   // first row of the sprite's 2x3 affine transform
+layout (location = 2) in vec4 instanceRow1;   // second row of the sprite's 2x3 affine transform
+layout (location = 3) in vec4 instanceColor;  // <vec3 color, float layer of an array texture>
+layout (location = 4) in vec4 instanceUV;     // <vec2 offset, vec2 size> of the sprite's region inside its texture
+#else
+uniform mat4 model;
+#ifdef ATLAS
+uniform vec4 uvRect; // <vec2 offset, vec2 size> of the sprite's region inside its texture
+#endif
+#ifdef ARRAY_TEXTURE
+uniform float layer;
+#endif
+#endif
 
 out vec2 TexCoords;
+#if defined(INSTANCED) && defined(TINT)
+out vec3 SpriteColor;
+#endif
+#ifdef ARRAY_TEXTURE
+flat out float Layer;
+#endif
 
-uniform mat4 model;
-uniform mat4 projection;
+#include "../common/frame_uniforms.glsl"
 
 void main()
 {
-    TexCoords = vec2(vertex.z , vertex.w);
-    gl_Position = projection * model * vec4(vertex.x , vertex.y, 0.0, 1.0);
+#ifdef INSTANCED
+    // the affine already holds scale, rotation around the center and translation (see sprite_transform.h)
+    vec3 local = vec3(vertex.xy, 1.0);
+    vec4 world = vec4(dot(instanceRow0.xyz, local), dot(instanceRow1.xyz, local), 0.0, 1.0);
+    vec4 rect = instanceUV;
+#ifdef TINT
+    SpriteColor = instanceColor.rgb;
+#endif
+#ifdef ARRAY_TEXTURE
+    Layer = instanceColor.a;
+#endif
+#else
+    vec4 world = model * vec4(vertex.xy, 0.0, 1.0);
+#ifdef ATLAS
+    vec4 rect = uvRect;
+#endif
+#ifdef ARRAY_TEXTURE
+    Layer = layer;
+#endif
+#endif
+
+#ifdef ATLAS
+    TexCoords = rect.xy + vertex.zw * rect.zw;
+#else
+    TexCoords = vertex.zw;
+#endif
+    gl_Position = projection * world;
 }
\ No newline at end of file
@@ -1,8 +1,8 @@
 #version 330 core
-layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+#include "../common/quad_vertex.glsl"
 out vec2 TexCoords;
 
-uniform mat4 projection;
+#include "../common/frame_uniforms.glsl"
 
 void main()
 {
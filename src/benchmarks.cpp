@@ -0,0 +1,179 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "benchmarks.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "cooked_texture.h"
+#include "resource_registry.h"
+#include "sprite_transform.h"
+#include "stb_image.h"
+
+
+namespace
+{
+    // measures the average time of one call to work over iterations runs, in nanoseconds
+    template <typename Work>
+    double timeNanoseconds(int iterations, Work work)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i)
+            work();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    }
+
+    void benchmarkSpriteTransforms(std::size_t count, int iterations)
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> coordinate(0.0f, 800.0f), extent(8.0f, 64.0f), angle(0.0f, 360.0f);
+        std::vector<float> x(count), y(count), width(count), height(count), rotation(count), radians(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            x[i] = coordinate(random);
+            y[i] = coordinate(random);
+            width[i] = extent(random);
+            height[i] = extent(random);
+            rotation[i] = angle(random);
+            radians[i] = glm::radians(rotation[i]);
+        }
+        std::vector<glm::mat4> models(count);
+        std::vector<SpriteAffine> affines(count);
+
+        // the mat4 chain DrawSprite used to build per sprite
+        double chain = timeNanoseconds(iterations, [&]()
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                glm::vec2 size(width[i], height[i]);
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, glm::vec3(x[i], y[i], 0.0f));
+                model = glm::translate(model, glm::vec3(0.5f * size.x, 0.5f * size.y, 0.0f));
+                model = glm::rotate(model, glm::radians(rotation[i]), glm::vec3(0.0f, 0.0f, 1.0f));
+                model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f));
+                models[i] = glm::scale(model, glm::vec3(size, 1.0f));
+            }
+        });
+        SpriteTransformInput in = { x.data(), y.data(), width.data(), height.data(), radians.data() };
+        double kernel = timeNanoseconds(iterations, [&]()
+        {
+            ComputeSpriteAffines(in, count, affines.data());
+        });
+
+        // both paths must agree, otherwise the timings mean nothing
+        float maxError = 0.0f;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            glm::mat4 expanded = SpriteAffineToMat4(affines[i]);
+            for (int column = 0; column < 4; ++column)
+                for (int row = 0; row < 4; ++row)
+                    maxError = glm::max(maxError, glm::abs(expanded[column][row] - models[i][column][row]));
+        }
+        std::cout << "sprite transforms (" << count << " sprites): mat4 chain " << chain / count << " ns/sprite, "
+            << "affine kernel " << kernel / count << " ns/sprite (" << chain / kernel << "x), max error " << maxError << std::endl;
+    }
+
+    // stand-in for a resource, the size of a texture view
+    struct LookupPayload
+    {
+        unsigned int ID, Width, Height;
+    };
+
+    // what ResourceManager::GetTexture used to do: string by value, map lookup, copy out
+    LookupPayload lookupByString(const std::map<std::string, LookupPayload> &resources, std::string name)
+    {
+        return resources.find(name)->second;
+    }
+
+    void benchmarkResourceLookups(int iterations)
+    {
+        // a resource set of realistic size; looking up "face" each frame is the case being measured
+        const int count = 64;
+        std::map<std::string, LookupPayload> byName;
+        ResourceRegistry<LookupPayload> registry;
+        for (int i = 0; i < count; ++i)
+        {
+            std::string name = "resource_" + std::to_string(i);
+            byName[name] = registry[registry.Insert(name)] = { static_cast<unsigned int>(i), 64, 64 };
+        }
+        byName["face"] = registry[registry.Insert("face")] = { 1000u, 512, 512 };
+        ResourceHandle<LookupPayload> handle = registry.Find("face"_id);
+
+        // volatile sink so the lookups can't be optimized away
+        volatile unsigned int sink = 0;
+        double string = timeNanoseconds(iterations, [&]()
+        {
+            sink = sink + lookupByString(byName, "face").ID;
+        });
+        double id = timeNanoseconds(iterations, [&]()
+        {
+            sink = sink + registry["face"_id].ID;
+        });
+        double indexed = timeNanoseconds(iterations, [&]()
+        {
+            sink = sink + registry[handle].ID;
+        });
+        std::cout << "resource lookups (" << count + 1 << " resources): std::map<std::string> " << string << " ns, "
+            << "hashed id " << id << " ns (" << string / id << "x), handle " << indexed << " ns (" << string / indexed << "x)" << std::endl;
+    }
+
+    // decode (stbi_load) against map (CookedTexture) for every image in resources/ that has been cooked. The
+    // first pass is as cold as the OS file cache allows (drop it first for true cold numbers), later passes are warm.
+    void benchmarkTextureLoads(int iterations)
+    {
+        std::vector<std::string> images;
+        std::error_code error;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator("resources", error))
+            if (entry.path().extension() == ".png" && std::filesystem::exists(CookedTexture::CookedPath(entry.path().string())))
+                images.push_back(entry.path().string());
+        if (images.empty())
+        {
+            std::cout << "texture loads: no cooked images in resources/, build the cook_textures target first" << std::endl;
+            return;
+        }
+        auto decodeAll = [&]()
+        {
+            for (const std::string &image : images)
+            {
+                int width, height, nrChannels;
+                stbi_image_free(stbi_load(image.c_str(), &width, &height, &nrChannels, 0));
+            }
+        };
+        auto mapAll = [&]()
+        {
+            for (const std::string &image : images)
+            {
+                CookedTexture cooked(CookedTexture::CookedPath(image));
+                cooked.Prefetch();
+            }
+        };
+        double mapCold = timeNanoseconds(1, mapAll) / 1e6;
+        double decodeCold = timeNanoseconds(1, decodeAll) / 1e6;
+        double mapWarm = timeNanoseconds(iterations, mapAll) / 1e6;
+        double decodeWarm = timeNanoseconds(iterations, decodeAll) / 1e6;
+        std::cout << "texture loads (" << images.size() << " images, without the GL upload): png decode " << decodeCold << " ms cold, "
+            << decodeWarm << " ms warm; btex map " << mapCold << " ms cold, " << mapWarm << " ms warm (" << decodeWarm / mapWarm << "x)" << std::endl;
+    }
+}
+
+void RunBenchmarks()
+{
+    benchmarkSpriteTransforms(10000, 200);
+    benchmarkResourceLookups(1000000);
+    benchmarkTextureLoads(20);
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+// Runs the CPU-side microbenchmarks (no GL context needed) and prints
+// their results; started with the --bench command line option.
+void RunBenchmarks();
+
+#endif
@@ -0,0 +1,157 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "cooked_texture.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+CookedTexture::CookedTexture(const std::string &file)
+    : data(nullptr), size(0), header(nullptr)
+{
+#ifdef _WIN32
+    this->mapping = nullptr;
+    this->file = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE)
+        return;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0)
+        return;
+    this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (this->mapping == nullptr)
+        return;
+    this->data = static_cast<const unsigned char*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (this->data == nullptr)
+        return;
+    this->size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        void *mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+            this->data = static_cast<const unsigned char*>(mapped);
+            this->size = static_cast<std::size_t>(info.st_size);
+        }
+    }
+    // the mapping keeps the file alive on its own
+    close(fd);
+    if (this->data == nullptr)
+        return;
+#endif
+    // only accept a file whose every level lies inside the mapping; the chain ends at 1x1
+    const BtexHeader *candidate = reinterpret_cast<const BtexHeader*>(this->data);
+    std::uint32_t maxLevels = 1;
+    if (this->size >= sizeof(BtexHeader))
+        for (std::uint32_t extent = std::max(candidate->Width, candidate->Height); extent > 1; extent /= 2)
+            ++maxLevels;
+    if (this->size < sizeof(BtexHeader) || candidate->Magic != BTEX_MAGIC || candidate->Version != BTEX_VERSION
+        || candidate->Width == 0 || candidate->Height == 0 || (candidate->Channels != 3 && candidate->Channels != 4)
+        || candidate->Levels == 0 || candidate->Levels > maxLevels
+        || this->size < sizeof(BtexHeader) + candidate->Levels * sizeof(BtexLevel))
+    {
+        std::cout << "ERROR::COOKED_TEXTURE: " << file << " is not a version " << BTEX_VERSION << " .btex file" << std::endl;
+        return;
+    }
+    const BtexLevel *levels = reinterpret_cast<const BtexLevel*>(this->data + sizeof(BtexHeader));
+    for (std::uint32_t level = 0; level < candidate->Levels; ++level)
+    {
+        // GL reads pitch * height bytes of the level whatever its Size says
+        std::uint32_t width = std::max(1u, candidate->Width >> level), height = std::max(1u, candidate->Height >> level);
+        if (levels[level].Offset > this->size || levels[level].Size > this->size - levels[level].Offset
+            || levels[level].Size / RowPitch(width, candidate->Channels) < height)
+        {
+            std::cout << "ERROR::COOKED_TEXTURE: " << file << " is truncated" << std::endl;
+            return;
+        }
+    }
+    this->header = candidate;
+}
+
+CookedTexture::~CookedTexture()
+{
+#ifdef _WIN32
+    if (this->data != nullptr)
+        UnmapViewOfFile(this->data);
+    if (this->mapping != nullptr)
+        CloseHandle(this->mapping);
+    if (this->file != INVALID_HANDLE_VALUE)
+        CloseHandle(this->file);
+#else
+    if (this->data != nullptr)
+        munmap(const_cast<unsigned char*>(this->data), this->size);
+#endif
+}
+
+const unsigned char *CookedTexture::Level(unsigned int level) const
+{
+    const BtexLevel *levels = reinterpret_cast<const BtexLevel*>(this->data + sizeof(BtexHeader));
+    return this->data + levels[level].Offset;
+}
+
+void CookedTexture::Prefetch() const
+{
+    // volatile so the reads aren't optimized away
+    volatile unsigned char sink = 0;
+    for (std::size_t offset = 0; offset < this->size; offset += 4096)
+        sink = sink + this->data[offset];
+}
+
+std::string CookedTexture::CookedPath(const std::string &source)
+{
+    std::string::size_type dot = source.find_last_of('.');
+    std::string::size_type slash = source.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return source + ".btex";
+    return source.substr(0, dot) + ".btex";
+}
+
+bool CookedTexture::Write(const std::string &file, const BtexHeader &header, const std::vector<std::vector<unsigned char>> &levels)
+{
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    std::vector<BtexLevel> table(levels.size());
+    std::uint64_t offset = sizeof(BtexHeader) + levels.size() * sizeof(BtexLevel);
+    for (std::size_t level = 0; level < levels.size(); ++level)
+    {
+        // 16-byte aligned levels keep every row 4-byte aligned for the upload
+        offset = (offset + 15) & ~static_cast<std::uint64_t>(15);
+        table[level] = { offset, levels[level].size() };
+        offset += levels[level].size();
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(BtexLevel));
+    for (std::size_t level = 0; level < levels.size(); ++level)
+    {
+        static const char padding[16] = { 0 };
+        out.write(padding, static_cast<std::streamsize>(table[level].Offset - static_cast<std::uint64_t>(out.tellp())));
+        out.write(reinterpret_cast<const char*>(levels[level].data()), levels[level].size());
+    }
+    if (!out)
+    {
+        std::cout << "ERROR::COOKED_TEXTURE: Failed to write " << file << std::endl;
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef COOKED_TEXTURE_H
+#define COOKED_TEXTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Layout of a .btex file, written by tools/texture_cooker: this header,
+// one BtexLevel per mip level, then the pixel data of every level. Pixels
+// are stored exactly as glTexImage2D takes them (8 bits per channel in
+// RGB or RGBA order, rows padded to 4 bytes), so they can be uploaded
+// straight from the mapped file.
+struct BtexHeader
+{
+    std::uint32_t Magic;      // BTEX_MAGIC
+    std::uint32_t Version;    // BTEX_VERSION
+    std::uint32_t Width, Height;
+    std::uint32_t Channels;   // 3 or 4
+    std::uint32_t Levels;     // mip levels, level 0 first
+    std::uint32_t Flags;      // BTEX_PREMULTIPLIED
+    std::uint32_t Reserved;
+};
+
+struct BtexLevel
+{
+    std::uint64_t Offset;     // from the start of the file
+    std::uint64_t Size;       // bytes
+};
+
+const std::uint32_t BTEX_MAGIC = 0x58455442;    // "BTEX"
+const std::uint32_t BTEX_VERSION = 1;
+// color channels were multiplied by alpha when cooking
+const std::uint32_t BTEX_PREMULTIPLIED = 1;
+
+// A read-only memory mapping of a .btex file (mmap on POSIX,
+// CreateFileMapping on Windows). Nothing is read up front: pages are
+// faulted in when the upload touches them, and the OS keeps them in its
+// file cache between launches.
+class CookedTexture
+{
+public:
+    // maps file; Valid() is false if it is missing or malformed
+    CookedTexture(const std::string &file);
+    // destructor (unmaps the file)
+    ~CookedTexture();
+    bool                 Valid() const { return this->header != nullptr; }
+    const BtexHeader    &Header() const { return *this->header; }
+    // pixels of a mip level, pointing into the mapping
+    const unsigned char *Level(unsigned int level) const;
+    // touches every page of the mapping, so later reads (the upload) don't wait for the disk
+    void                 Prefetch() const;
+    // bytes between the rows of a level width pixels wide
+    static std::size_t   RowPitch(std::uint32_t width, std::uint32_t channels) { return (static_cast<std::size_t>(width) * channels + 3) & ~static_cast<std::size_t>(3); }
+    // the cooked file belonging to a source image: same path, .btex extension
+    static std::string   CookedPath(const std::string &source);
+    // writes a .btex file; levels holds every mip level's pixels in the layout described above
+    static bool          Write(const std::string &file, const BtexHeader &header, const std::vector<std::vector<unsigned char>> &levels);
+private:
+    const unsigned char *data;
+    std::size_t          size;
+    const BtexHeader    *header;     // nullptr unless the file was mapped and checked
+#ifdef _WIN32
+    void                *file;
+    void                *mapping;
+#endif
+    // disable copying, the object owns the mapping
+    CookedTexture(const CookedTexture &) = delete;
+    CookedTexture &operator=(const CookedTexture &) = delete;
+};
+
+#endif
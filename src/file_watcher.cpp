@@ -0,0 +1,180 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+
+FileWatcher::FileWatcher(const std::vector<std::string> &files)
+    : changed(false), stopping(false), watching(false)
+{
+    for (const std::string &file : files)
+    {
+        std::string::size_type slash = file.find_last_of("/\\");
+        std::string directory = slash == std::string::npos ? "." : file.substr(0, slash);
+        std::vector<std::string> &watched = this->directories[directory];
+        if (std::find(watched.begin(), watched.end(), file) == watched.end())
+            watched.push_back(file);
+    }
+#if defined(__linux__)
+    this->inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    this->wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (this->inotifyFd < 0 || this->wakeFd < 0)
+    {
+        std::cout << "ERROR::FILE_WATCHER: Failed to create inotify instance" << std::endl;
+        return;
+    }
+    for (auto &directory : this->directories)
+    {
+        int wd = inotify_add_watch(this->inotifyFd, directory.first.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0)
+            std::cout << "ERROR::FILE_WATCHER: Failed to watch " << directory.first << std::endl;
+        else
+            this->watches[wd] = directory.first;
+    }
+    this->watching = !this->watches.empty();
+#elif defined(_WIN32)
+    this->stopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    for (auto &directory : this->directories)
+    {
+        HANDLE handle = FindFirstChangeNotificationA(directory.first.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+        if (handle == INVALID_HANDLE_VALUE)
+            std::cout << "ERROR::FILE_WATCHER: Failed to watch " << directory.first << std::endl;
+        this->handles.push_back(handle);
+    }
+    // WaitForMultipleObjects takes the stop event plus at most MAXIMUM_WAIT_OBJECTS - 1 directories
+    this->watching = this->stopEvent != nullptr && !this->handles.empty() && this->handles.size() < MAXIMUM_WAIT_OBJECTS;
+#else
+    std::cout << "ERROR::FILE_WATCHER: No file watcher on this platform" << std::endl;
+#endif
+    if (this->watching)
+        this->thread = std::thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    this->stopping.store(true);
+#if defined(__linux__)
+    if (this->thread.joinable())
+    {
+        std::uint64_t one = 1;
+        if (write(this->wakeFd, &one, sizeof(one)) != sizeof(one))
+            std::cout << "ERROR::FILE_WATCHER: Failed to wake watcher thread" << std::endl;
+        this->thread.join();
+    }
+    if (this->inotifyFd >= 0)
+        close(this->inotifyFd);
+    if (this->wakeFd >= 0)
+        close(this->wakeFd);
+#elif defined(_WIN32)
+    if (this->thread.joinable())
+    {
+        SetEvent(this->stopEvent);
+        this->thread.join();
+    }
+    for (void *handle : this->handles)
+        if (handle != INVALID_HANDLE_VALUE)
+            FindCloseChangeNotification(handle);
+    if (this->stopEvent != nullptr)
+        CloseHandle(this->stopEvent);
+#endif
+}
+
+bool FileWatcher::IsWatched(const std::string &path) const
+{
+    // directories is never changed after construction, so the watcher thread doesn't get in the way
+    std::string::size_type slash = path.find_last_of("/\\");
+    auto directory = this->directories.find(slash == std::string::npos ? "." : path.substr(0, slash));
+    return directory != this->directories.end() && std::find(directory->second.begin(), directory->second.end(), path) != directory->second.end();
+}
+
+std::vector<std::string> FileWatcher::TakeChanges()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<std::string> changes(this->pending.begin(), this->pending.end());
+    this->pending.clear();
+    this->changed.store(false, std::memory_order_release);
+    return changes;
+}
+
+void FileWatcher::notify(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->pending.insert(path);
+    this->changed.store(true, std::memory_order_release);
+}
+
+void FileWatcher::run()
+{
+#if defined(__linux__)
+    // inotify_event is followed by its name, so align the buffer like the struct
+    alignas(inotify_event) char buffer[4096];
+    pollfd fds[2] = { { this->inotifyFd, POLLIN, 0 }, { this->wakeFd, POLLIN, 0 } };
+    while (!this->stopping.load())
+    {
+        if (poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN))
+            continue;
+        ssize_t length;
+        while ((length = read(this->inotifyFd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char *ptr = buffer; ptr < buffer + length; )
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event*>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+                auto watch = this->watches.find(event->wd);
+                if (event->len == 0 || watch == this->watches.end())
+                    continue;
+                // only report the files we were asked to watch, not everything else in the directory
+                std::string name(event->name);
+                for (const std::string &file : this->directories.find(watch->second)->second)
+                    if (file.size() >= name.size() && file.compare(file.size() - name.size(), name.size(), name) == 0
+                        && (file.size() == name.size() || file[file.size() - name.size() - 1] == '/' || file[file.size() - name.size() - 1] == '\\'))
+                        this->notify(file);
+            }
+        }
+    }
+#elif defined(_WIN32)
+    // change notifications don't say which file changed, so every watched file of the directory is reported
+    std::vector<HANDLE> waits(1, this->stopEvent);
+    std::vector<const std::vector<std::string>*> files(1, nullptr);
+    std::size_t index = 0;
+    for (auto &directory : this->directories)
+    {
+        if (this->handles[index] != INVALID_HANDLE_VALUE)
+        {
+            waits.push_back(this->handles[index]);
+            files.push_back(&directory.second);
+        }
+        ++index;
+    }
+    while (!this->stopping.load())
+    {
+        DWORD result = WaitForMultipleObjects(static_cast<DWORD>(waits.size()), waits.data(), FALSE, INFINITE);
+        if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + waits.size())
+            break;
+        std::size_t signaled = result - WAIT_OBJECT_0;
+        for (const std::string &file : *files[signaled])
+            this->notify(file);
+        FindNextChangeNotification(waits[signaled]);
+    }
+#endif
+}
\ No newline at end of file
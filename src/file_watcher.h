@@ -0,0 +1,69 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Watches a fixed list of files for modifications on a background
+// thread. The thread sleeps in the OS (inotify on Linux, change
+// notification handles on Windows) until one of the files' directories
+// changes, so watching costs nothing while no file is touched; the
+// owner only checks HasChanges once per frame, a single atomic load.
+// Directories are watched instead of the files themselves so editors
+// that save by writing a temporary file and renaming it are caught too.
+class FileWatcher
+{
+public:
+    // constructor (starts watching files; paths are reported back exactly as given)
+    FileWatcher(const std::vector<std::string> &files);
+    // destructor (stops the watcher thread)
+    ~FileWatcher();
+    // true if any watched file changed since the last TakeChanges
+    bool        HasChanges() const { return this->changed.load(std::memory_order_acquire); }
+    // returns and forgets the paths of all files that changed since the last call
+    std::vector<std::string> TakeChanges();
+    // false if the platform has no watcher backend or it failed to start
+    bool        IsWatching() const { return this->watching; }
+    // true if path was one of the files given to the constructor
+    bool        IsWatched(const std::string &path) const;
+private:
+    // watched paths grouped by directory
+    std::map<std::string, std::vector<std::string>> directories;
+    std::mutex        mutex;
+    std::set<std::string> pending;   // guarded by mutex
+    std::atomic<bool> changed;
+    std::atomic<bool> stopping;
+    bool              watching;
+    std::thread       thread;
+#if defined(__linux__)
+    int               inotifyFd;
+    int               wakeFd;        // written by the destructor to interrupt the thread's poll
+    std::map<int, std::string> watches;      // inotify watch descriptor -> directory
+#elif defined(_WIN32)
+    void             *stopEvent;
+    std::vector<void*> handles;               // one change notification per directory, same order as directories
+#endif
+    // thread body, blocks on the OS until a directory changes
+    void run();
+    // records changes to path (from any thread)
+    void notify(const std::string &path);
+    // disable copying, the watcher owns a thread and OS handles
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+};
+
+#endif
@@ -0,0 +1,44 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "fixed_timestep.h"
+
+#include <cmath>
+
+
+FixedTimestep::FixedTimestep(double tickRate, unsigned int maxSteps)
+    : MaxSteps(maxSteps), step(1.0 / tickRate), accumulator(0.0), ticks(0), dropped(0.0)
+{
+
+}
+
+unsigned int FixedTimestep::Advance(double frameSeconds)
+{
+    if (frameSeconds > 0.0)
+        this->accumulator += frameSeconds;
+    unsigned int steps = 0;
+    while (this->accumulator >= this->step && steps < this->MaxSteps)
+    {
+        this->accumulator -= this->step;
+        ++steps;
+    }
+    // more time left than one tick means the frame hit the limit: let the simulation fall behind wall time instead
+    if (this->accumulator >= this->step)
+    {
+        double remainder = std::fmod(this->accumulator, this->step);
+        this->dropped += this->accumulator - remainder;
+        this->accumulator = remainder;
+    }
+    this->ticks += steps;
+    return steps;
+}
+
+void FixedTimestep::SetTickRate(double tickRate)
+{
+    this->step = 1.0 / tickRate;
+}
\ No newline at end of file
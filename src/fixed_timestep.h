@@ -0,0 +1,46 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+
+// Turns variable frame times into a whole number of fixed simulation
+// ticks. Frame time is added to an accumulator and every full Step()
+// in it becomes one tick; the remainder carries over to the next frame
+// and, as Alpha(), tells the renderer how far it is between the last
+// two simulation states. A frame never runs more than MaxSteps ticks:
+// after a hitch the time beyond that is dropped instead of being caught
+// up, which would make the next frame slower still (spiral of death).
+class FixedTimestep
+{
+public:
+    // ticks per second of simulated time and the most ticks a single frame may run
+    FixedTimestep(double tickRate = 60.0, unsigned int maxSteps = 5);
+    // adds a frame's duration and returns the number of ticks to simulate now
+    unsigned int Advance(double frameSeconds);
+    // seconds of simulated time per tick
+    double       Step() const { return this->step; }
+    // fraction of a tick accumulated since the last one, in [0, 1): the blend factor between the previous and current state
+    float        Alpha() const { return static_cast<float>(this->accumulator / this->step); }
+    // when tick (0 to ticks - 1) of the ticks the last Advance returned ends, if that Advance was called at time now
+    double       TickTime(double now, unsigned int tick, unsigned int ticks) const { return now - this->accumulator - (ticks - 1 - tick) * this->step; }
+    // changes the tick rate, keeping the accumulated time
+    void         SetTickRate(double tickRate);
+    // counters since construction
+    unsigned long long Ticks() const { return this->ticks; }
+    double       DroppedSeconds() const { return this->dropped; }
+    unsigned int MaxSteps;
+private:
+    double             step;
+    double             accumulator;
+    unsigned long long ticks;
+    double             dropped;
+};
+
+#endif
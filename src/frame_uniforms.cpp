@@ -0,0 +1,68 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "frame_uniforms.h"
+#include "gl_state.h"
+#include "shader.h"
+
+// Instantiate static variables
+FrameUniformData FrameUniforms::data = { glm::mat4(1.0f), glm::mat4(1.0f), glm::vec2(0.0f), 0.0f, 0.0f };
+unsigned int     FrameUniforms::buffer = 0;
+bool             FrameUniforms::dirty = true;
+
+
+void FrameUniforms::Init()
+{
+    buffer = GLState::GenBuffer();
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), &data, GL_DYNAMIC_DRAW);
+    GLState::BindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer);
+    // GLSL 330 has no layout(binding = ...), so programs get their block binding after linking
+    Shader::BindUniformBlock("Frame", BINDING);
+    dirty = false;
+}
+
+void FrameUniforms::SetProjection(const glm::mat4 &projection)
+{
+    data.Projection = projection;
+    dirty = true;
+}
+
+void FrameUniforms::SetView(const glm::mat4 &view)
+{
+    data.View = view;
+    dirty = true;
+}
+
+void FrameUniforms::SetResolution(float width, float height)
+{
+    data.Resolution = glm::vec2(width, height);
+    dirty = true;
+}
+
+void FrameUniforms::SetTime(float time)
+{
+    data.Time = time;
+    dirty = true;
+}
+
+void FrameUniforms::Upload()
+{
+    if (!dirty || buffer == 0)
+        return;
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformData), &data);
+    dirty = false;
+}
+
+void FrameUniforms::Clear()
+{
+    GLState::DeleteBuffer(buffer);
+    buffer = 0;
+    dirty = true;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <cstddef>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+
+// C++ mirror of the std140 Frame uniform block declared in
+// shaders/common/frame_uniforms.glsl. Members must stay at the offsets
+// std140 assigns them (mat4 on 16 bytes, vec2 on 8, float on 4); the
+// static_asserts below fail the build if the two drift apart.
+struct FrameUniformData
+{
+    glm::mat4 Projection;
+    glm::mat4 View;
+    glm::vec2 Resolution;
+    float     Time;
+    float     Padding;     // std140 rounds the block up to a multiple of 16 bytes
+};
+static_assert(offsetof(FrameUniformData, Projection) == 0, "std140: projection at offset 0");
+static_assert(offsetof(FrameUniformData, View) == 64, "std140: view at offset 64");
+static_assert(offsetof(FrameUniformData, Resolution) == 128, "std140: resolution at offset 128");
+static_assert(offsetof(FrameUniformData, Time) == 136, "std140: time at offset 136");
+static_assert(sizeof(FrameUniformData) == 144, "std140: Frame block is 144 bytes");
+
+// A static singleton holding the uniform buffer behind the Frame block.
+// The buffer is bound to BINDING once and every program's Frame block
+// is pointed at it when the program links, so changing the projection
+// or the time costs a single buffer update per frame (in Upload), no
+// matter how many programs read it.
+class FrameUniforms
+{
+public:
+    // uniform buffer binding point of the Frame block
+    static const GLuint BINDING = 0;
+    // creates the buffer and binds it; call before any shader is loaded
+    static void Init();
+    // setters, only recorded until the next Upload
+    static void SetProjection(const glm::mat4 &projection);
+    static void SetView(const glm::mat4 &view);
+    static void SetResolution(float width, float height);
+    static void SetTime(float time);
+    // writes the block to the buffer if anything changed since the last Upload; call once per frame before rendering
+    static void Upload();
+    // the values as of the last setter calls
+    static const FrameUniformData &Data() { return data; }
+    // deletes the buffer
+    static void Clear();
+private:
+    // private constructor, that is we do not want any actual frame uniform objects. Its members and functions should be publicly available (static).
+    FrameUniforms() { }
+    static FrameUniformData data;
+    static unsigned int     buffer;
+    static bool             dirty;
+};
+
+#endif
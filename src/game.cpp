@@ -13,46 +13,106 @@
 #include "game.h"
 #include "resource_manager.h"
 #include "sprite_renderer.h"
+#include "null_render_backend.h"
+#include "render_queue.h"
+#include "frame_uniforms.h"
 
 
 // Game-related State data
-SpriteRenderer    *Renderer;
+RenderBackend     *Backend;
+SpriteRenderer    *Renderer;    // the backend if it is the GL one, nullptr otherwise
+RenderQueue       *Queue;
+ResourceHandle<AtlasRegion> FaceSprite;
 
 Game::Game(unsigned int width, unsigned int height) 
-    : State(GAME_MENU), Keys(), Width(width), Height(height)
+    : State(GAME_MENU), Width(width), Height(height), face{ glm::vec2(200.0f, 200.0f), 45.0f }
 {}
 
 Game::~Game()
 {
-    delete Renderer;
+    this->Shutdown();
 }
 
-void Game::Init()
+void Game::Shutdown()
 {
-    // Load shaders
-    ResourceManager::LoadShader("shaders/sprite/vertShader.glsl", "shaders/sprite/fragShader.glsl", nullptr, "sprite");
+    if (Renderer != nullptr && Renderer->InstanceStream() != nullptr)
+    {
+        const StreamBuffer *stream = Renderer->InstanceStream();
+        std::cout << "Sprite instance stream: " << (stream->IsPersistent() ? "persistent" : "orphaning")
+            << ", " << stream->RegionSwitches() << " region switches, " << stream->Stalls() << " stalls" << std::endl;
+    }
+    delete Queue;
+    delete Backend;
+    Queue = nullptr;
+    Backend = nullptr;
+    Renderer = nullptr;
+}
+
+void Game::Init(RenderBackendType backend)
+{
+    // Configure the projection; the Frame uniform block only records it until a GL backend uploads it
+    FrameUniforms::SetProjection(glm::ortho(0.0f, static_cast<GLfloat>(this->Width), static_cast<GLfloat>(this->Height), 0.0f, -1.0f, 1.0f));
+    FrameUniforms::SetResolution(static_cast<float>(this->Width), static_cast<float>(this->Height));
+    if (backend == RENDER_BACKEND_NULL)
+    {
+        // no GL context: nothing is loaded, sprites get stand-in regions the null backend never samples
+        FaceSprite = ResourceManager::AtlasRegions.Insert("face");
+        ResourceManager::AtlasRegions[FaceSprite] = { 1, 0, 512, 512, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), false };
+        Backend = new NullRenderBackend();
+        Queue = new RenderQueue(*Backend);
+        return;
+    }
+    // Load shaders: the permutations the sprite renderer needs, compiled in parallel by the driver
+    ResourceManager::RegisterShaderVariants("shaders/sprite/vertShader.glsl", "shaders/sprite/fragShader.glsl", nullptr, "sprite");
+    ResourceManager::BeginShaderBatch();
+    Shader &sprite = ResourceManager::GetShaderVariant("sprite", { "ATLAS", "TINT" });
+    Shader &spriteInstanced = ResourceManager::GetShaderVariant("sprite", { "INSTANCED", "ATLAS", "TINT" });
+    Shader &spriteArray = ResourceManager::GetShaderVariant("sprite", { "INSTANCED", "ATLAS", "TINT", "ARRAY_TEXTURE" });
+    ResourceManager::EndShaderBatch();
     // Configure shaders
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(this->Width), static_cast<GLfloat>(this->Height), 0.0f, -1.0f, 1.0f);
-    ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
-    ResourceManager::GetShader("sprite").SetMatrix4("projection", projection);
-    // Load textures
-    ResourceManager::LoadTexture("resources/awesomeface.png", GL_TRUE, "face");
+    sprite.Use().SetInteger("image", 0);
+    spriteInstanced.Use().SetInteger("image", 0);
+    spriteArray.Use().SetInteger("image", 0);
+    // Load textures; they are decoded in the background and show up once FinalizeLoads uploaded them
+    FaceSprite = ResourceManager::LoadAtlasTextureAsync("resources/awesomeface.png", "face");
     // Set render-specific controls
-    Renderer = new SpriteRenderer(ResourceManager::GetShader("sprite"));
+    Renderer = new SpriteRenderer(sprite, spriteInstanced, spriteArray);
+    Backend = Renderer;
+    Queue = new RenderQueue(*Backend);
 }
 
 void Game::Update(GLfloat dt)
 {
+    // dt is the fixed tick length, so this turns at the same speed whatever the frame rate
+    this->face.Rotation += 45.0f * dt;
+}
 
+void Game::Snapshot(GameSnapshot &snapshot) const
+{
+    snapshot.Face = this->face;
 }
 
 
-void Game::ProcessInput(GLfloat dt)
+void Game::ProcessInput(GLfloat dt, double time)
 {
+    this->Input.Advance(this->Events, time);
+}
 
+void Game::Render(const GameSnapshot &previous, const GameSnapshot &current, GLfloat alpha)
+{
+    // sprites whose texture is still loading are skipped
+    const AtlasRegion &face = ResourceManager::GetAtlasRegion(FaceSprite);
+    if (face.Texture != 0)
+    {
+        glm::vec2 position = glm::mix(previous.Face.Position, current.Face.Position, alpha);
+        GLfloat rotation = glm::mix(previous.Face.Rotation, current.Face.Rotation, alpha);
+        Queue->DrawSprite(0, face, position, glm::vec2(300, 400), rotation, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    // sort and submit everything recorded this frame
+    Queue->Execute();
 }
 
-void Game::Render()
+const RenderBackendStats &Game::RenderStats() const
 {
-    Renderer->DrawSprite(ResourceManager::GetTexture("face"), glm::vec2(200, 200), glm::vec2(300, 400), 45.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+    return Backend->Stats();
 }
\ No newline at end of file
@@ -13,6 +13,11 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "input_queue.h"
+#include "input_state.h"
+#include "render_backend.h"
 
 // Represents the current state of the game
 enum GameState {
@@ -20,23 +25,51 @@ enum GameState {
     GAME_MENU,
     GAME_WIN
 };
+// Simulated state of a sprite
+struct SpriteState
+{
+    glm::vec2 Position;
+    GLfloat   Rotation;
+};
+
+// Everything Render needs from the simulation, copied out after every
+// tick so rendering never reads state the simulation is changing
+struct GameSnapshot
+{
+    SpriteState Face;
+};
+
 class Game
 {
 public:
     // Ϸ״̬
     GameState  State;
-    GLboolean  Keys[1024];
+    // written by the GLFW key callback, consumed by ProcessInput, possibly on another thread
+    InputQueue Events;
+    // the keyboard during the current tick, only touched by ProcessInput and Update
+    InputState Input;
     GLuint     Width, Height;
 
     // 캯/
     Game(GLuint width, GLuint height);
     ~Game();
     // ʼϷ״̬еɫ//ؿ
-    void Init();
+    void Init(RenderBackendType backend = RENDER_BACKEND_GL);
+    // releases the renderer and its GL objects; call while the GL context is still current (the destructor runs after main)
+    void Shutdown();
     // Ϸѭ
-    void ProcessInput(GLfloat dt);
+    // consumes the input events up to time, the end of the tick being simulated (see FixedTimestep::TickTime)
+    void ProcessInput(GLfloat dt, double time);
     void Update(GLfloat dt);
-    void Render();
+    // copies the simulation state that Render needs
+    void Snapshot(GameSnapshot &snapshot) const;
+    // draws the blend of two consecutive snapshots, alpha = 0 being previous (see FixedTimestep::Alpha)
+    void Render(const GameSnapshot &previous, const GameSnapshot &current, GLfloat alpha);
+    // counters of the backend Render draws through
+    const RenderBackendStats &RenderStats() const;
+private:
+    // simulation state, only touched by ProcessInput and Update
+    SpriteState face;
 };
 
 #endif
\ No newline at end of file
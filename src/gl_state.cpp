@@ -0,0 +1,288 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "gl_state.h"
+
+
+namespace
+{
+    // no GL object or enum uses this value, so a shadow holding it never matches
+    const unsigned int UNKNOWN = 0xFFFFFFFFu;
+}
+
+// Instantiate static variables
+unsigned int GLState::program = UNKNOWN;
+unsigned int GLState::activeUnit = UNKNOWN;
+unsigned int GLState::textures[GLState::MAX_TEXTURE_UNITS][GLState::TEXTURE_TARGETS];
+unsigned int GLState::vertexArray = UNKNOWN;
+unsigned int GLState::buffers[GLState::BUFFER_TARGETS];
+int          GLState::blendEnabled = -1;
+GLenum       GLState::blendSource = UNKNOWN;
+GLenum       GLState::blendDestination = UNKNOWN;
+int          GLState::viewport[4] = { -1, -1, -1, -1 };
+GLStateStats GLState::frame;
+GLStateStats GLState::lastFrame;
+GLStateStats GLState::total;
+unsigned int GLState::frames = 0;
+GLObjectCounts GLState::live = { 0, 0, 0, 0 };
+
+
+void GLState::UseProgram(unsigned int program)
+{
+    if (count(GLState::program != program))
+    {
+        glUseProgram(program);
+        GLState::program = program;
+    }
+}
+
+void GLState::ActiveTexture(unsigned int unit)
+{
+    if (count(activeUnit != unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+}
+
+void GLState::BindTexture(GLenum target, unsigned int texture)
+{
+    int index = textureTargetIndex(target);
+    if (index < 0 || activeUnit >= MAX_TEXTURE_UNITS)
+    {
+        count(true);
+        glBindTexture(target, texture);
+        return;
+    }
+    if (count(textures[activeUnit][index] != texture))
+    {
+        glBindTexture(target, texture);
+        textures[activeUnit][index] = texture;
+    }
+}
+
+void GLState::BindTexture(unsigned int unit, GLenum target, unsigned int texture)
+{
+    int index = textureTargetIndex(target);
+    // only switch units if the binding there actually changes
+    if (index >= 0 && unit < MAX_TEXTURE_UNITS && textures[unit][index] == texture)
+    {
+        count(false);
+        return;
+    }
+    ActiveTexture(unit);
+    BindTexture(target, texture);
+}
+
+void GLState::BindVertexArray(unsigned int vertexArray)
+{
+    if (count(GLState::vertexArray != vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+        GLState::vertexArray = vertexArray;
+    }
+}
+
+void GLState::BindBuffer(GLenum target, unsigned int buffer)
+{
+    int index = bufferTargetIndex(target);
+    if (index < 0)
+    {
+        count(true);
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (count(buffers[index] != buffer))
+    {
+        glBindBuffer(target, buffer);
+        buffers[index] = buffer;
+    }
+}
+
+void GLState::BindBufferBase(GLenum target, unsigned int index, unsigned int buffer)
+{
+    // indexed bindings are set once at startup, so only the generic binding GL changes as a side effect is shadowed
+    count(true);
+    glBindBufferBase(target, index, buffer);
+    int generic = bufferTargetIndex(target);
+    if (generic >= 0)
+        buffers[generic] = buffer;
+}
+
+void GLState::Blend(bool enabled)
+{
+    if (count(blendEnabled != static_cast<int>(enabled)))
+    {
+        if (enabled)
+            glEnable(GL_BLEND);
+        else
+            glDisable(GL_BLEND);
+        blendEnabled = enabled;
+    }
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination)
+{
+    if (count(blendSource != source || blendDestination != destination))
+    {
+        glBlendFunc(source, destination);
+        blendSource = source;
+        blendDestination = destination;
+    }
+}
+
+void GLState::Viewport(int x, int y, int width, int height)
+{
+    if (count(viewport[0] != x || viewport[1] != y || viewport[2] != width || viewport[3] != height))
+    {
+        glViewport(x, y, width, height);
+        viewport[0] = x;
+        viewport[1] = y;
+        viewport[2] = width;
+        viewport[3] = height;
+    }
+}
+
+unsigned int GLState::CreateProgram()
+{
+    ++live.Programs;
+    return glCreateProgram();
+}
+
+unsigned int GLState::GenTexture()
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    ++live.Textures;
+    return texture;
+}
+
+unsigned int GLState::GenBuffer()
+{
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    ++live.Buffers;
+    return buffer;
+}
+
+unsigned int GLState::GenVertexArray()
+{
+    unsigned int vertexArray;
+    glGenVertexArrays(1, &vertexArray);
+    ++live.VertexArrays;
+    return vertexArray;
+}
+
+void GLState::DeleteProgram(unsigned int program)
+{
+    if (program == 0)
+        return;
+    --live.Programs;
+    // a current program lives on until another one is used; just make sure the next Use reaches GL
+    if (GLState::program == program)
+        GLState::program = UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void GLState::DeleteTexture(unsigned int texture)
+{
+    if (texture == 0)
+        return;
+    --live.Textures;
+    // GL rebinds 0 wherever a deleted texture was bound
+    for (auto &unit : textures)
+        for (unsigned int &binding : unit)
+            if (binding == texture)
+                binding = 0;
+    glDeleteTextures(1, &texture);
+}
+
+void GLState::DeleteVertexArray(unsigned int vertexArray)
+{
+    if (vertexArray == 0)
+        return;
+    --live.VertexArrays;
+    if (GLState::vertexArray == vertexArray)
+        GLState::vertexArray = 0;
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void GLState::DeleteBuffer(unsigned int buffer)
+{
+    if (buffer == 0)
+        return;
+    --live.Buffers;
+    for (unsigned int &binding : buffers)
+        if (binding == buffer)
+            binding = 0;
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLState::Invalidate()
+{
+    program = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (auto &unit : textures)
+        for (unsigned int &binding : unit)
+            binding = UNKNOWN;
+    vertexArray = UNKNOWN;
+    for (unsigned int &binding : buffers)
+        binding = UNKNOWN;
+    blendEnabled = -1;
+    blendSource = blendDestination = UNKNOWN;
+    for (int &value : viewport)
+        value = -1;
+}
+
+void GLState::EndFrame()
+{
+    lastFrame = frame;
+    frame = GLStateStats();
+    frames++;
+}
+
+int GLState::textureTargetIndex(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D:       return 0;
+    case GL_TEXTURE_2D_ARRAY: return 1;
+    default:                  return -1;
+    }
+}
+
+int GLState::bufferTargetIndex(GLenum target)
+{
+    // GL_ELEMENT_ARRAY_BUFFER is vertex array state, so it is deliberately not shadowed here
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:        return 0;
+    case GL_PIXEL_UNPACK_BUFFER: return 1;
+    case GL_PIXEL_PACK_BUFFER:   return 2;
+    case GL_UNIFORM_BUFFER:      return 3;
+    case GL_COPY_WRITE_BUFFER:   return 4;
+    default:                     return -1;
+    }
+}
+
+bool GLState::count(bool changed)
+{
+#ifndef NDEBUG
+    if (changed)
+    {
+        frame.Issued++;
+        total.Issued++;
+    }
+    else
+    {
+        frame.Skipped++;
+        total.Skipped++;
+    }
+#endif
+    return changed;
+}
\ No newline at end of file
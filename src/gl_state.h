@@ -0,0 +1,99 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+
+// Number of GL calls the state cache let through vs. filtered out
+struct GLStateStats
+{
+    unsigned int Issued;
+    unsigned int Skipped;
+};
+
+// Number of GL objects created through GLState and not deleted yet
+struct GLObjectCounts
+{
+    int Programs;
+    int Textures;
+    int Buffers;
+    int VertexArrays;
+};
+
+// A static singleton that shadows the GL binding state of the current
+// context (program, texture units, vertex array, buffers, blending and
+// viewport) and drops calls that wouldn't change it. All code that
+// binds GL objects should go through it, otherwise the shadow copy
+// goes stale; call Invalidate after GL state was changed behind its
+// back. Objects must be deleted through the Delete* functions so a
+// recycled GL name is never mistaken for a binding that is still live.
+// Creating objects through the Create/Gen functions as well keeps a
+// count of live objects for leak reports. Debug builds count issued and
+// skipped calls per frame.
+class GLState
+{
+public:
+    // number of texture units whose bindings are tracked
+    static const unsigned int MAX_TEXTURE_UNITS = 16;
+    // state changes
+    static void UseProgram(unsigned int program);
+    static void ActiveTexture(unsigned int unit); // unit index, i.e. 0 for GL_TEXTURE0
+    static void BindTexture(GLenum target, unsigned int texture); // binds to the active unit
+    static void BindTexture(unsigned int unit, GLenum target, unsigned int texture);
+    static void BindVertexArray(unsigned int vertexArray);
+    static void BindBuffer(GLenum target, unsigned int buffer);
+    static void BindBufferBase(GLenum target, unsigned int index, unsigned int buffer); // indexed binding, also sets the generic one
+    static void Blend(bool enabled);
+    static void BlendFunc(GLenum source, GLenum destination);
+    static void Viewport(int x, int y, int width, int height);
+    // object creation, counted in LiveObjects
+    static unsigned int CreateProgram();
+    static unsigned int GenTexture();
+    static unsigned int GenBuffer();
+    static unsigned int GenVertexArray();
+    // object deletion, keeping the shadow state in sync with what GL unbinds implicitly (deleting name 0 is a no-op)
+    static void DeleteProgram(unsigned int program);
+    static void DeleteTexture(unsigned int texture);
+    static void DeleteVertexArray(unsigned int vertexArray);
+    static void DeleteBuffer(unsigned int buffer);
+    // forgets all shadowed state, the next call of every kind reaches GL
+    static void Invalidate();
+    // closes the current frame's counters
+    static void EndFrame();
+    // counters of the last completed frame and of all frames so far (zero in release builds)
+    static GLStateStats LastFrame() { return lastFrame; }
+    static GLStateStats Total() { return total; }
+    static unsigned int Frames() { return frames; }
+    // objects created and not yet deleted
+    static GLObjectCounts LiveObjects() { return live; }
+private:
+    // private constructor, that is we do not want any actual state cache objects. Its members and functions should be publicly available (static).
+    GLState() { }
+    // tracked texture targets and buffer targets; untracked targets always reach GL
+    enum { TEXTURE_TARGETS = 2, BUFFER_TARGETS = 5 };
+    static int  textureTargetIndex(GLenum target);
+    static int  bufferTargetIndex(GLenum target);
+    // counts a call that reached GL (changed == true) or was filtered out
+    static bool count(bool changed);
+    static unsigned int program;
+    static unsigned int activeUnit;
+    static unsigned int textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    static unsigned int vertexArray;
+    static unsigned int buffers[BUFFER_TARGETS];
+    static int          blendEnabled;
+    static GLenum       blendSource, blendDestination;
+    static int          viewport[4];
+    static GLStateStats frame, lastFrame, total;
+    static unsigned int frames;
+    static GLObjectCounts live;
+};
+
+#endif
@@ -0,0 +1,41 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+// 32-bit FNV-1a hash of a zero terminated string. constexpr, so names
+// known at compile time can be hashed by the compiler.
+constexpr std::uint32_t Fnv1a(const char *text, std::uint32_t hash = 2166136261u)
+{
+    while (*text != '\0')
+    {
+        hash ^= static_cast<unsigned char>(*text++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 64-bit FNV-1a hash of size bytes; pass a previous result as hash to
+// hash several buffers as if they were one.
+inline std::uint64_t Fnv1a64(const void *data, std::size_t size, std::uint64_t hash = 14695981039346656037ull)
+{
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#endif
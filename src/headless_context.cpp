@@ -0,0 +1,95 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "headless_context.h"
+
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// Instantiate static variables
+void *HeadlessContext::display = nullptr;
+void *HeadlessContext::context = nullptr;
+
+
+bool HeadlessContext::Create(int major, int minor)
+{
+#if defined(__linux__)
+    // the surfaceless platform needs no display server; plain eglGetDisplay would pick X11 or Wayland
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (extensions == nullptr || std::strstr(extensions, "EGL_MESA_platform_surfaceless") == nullptr || getPlatformDisplay == nullptr)
+    {
+        std::cout << "ERROR::HEADLESS_CONTEXT: EGL has no surfaceless platform" << std::endl;
+        return false;
+    }
+    EGLDisplay eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    EGLint eglMajor, eglMinor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor))
+    {
+        std::cout << "ERROR::HEADLESS_CONTEXT: Failed to initialize the surfaceless EGL display" << std::endl;
+        return false;
+    }
+    // configs default to window surfaces, which the surfaceless platform has none of
+    const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configs = 0;
+    EGLContext eglContext = EGL_NO_CONTEXT;
+    if (eglBindAPI(EGL_OPENGL_API) && eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configs) && configs > 0)
+        eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+    // a context without any surface needs EGL_KHR_surfaceless_context, which the surfaceless platform always has
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+    {
+        std::cout << "ERROR::HEADLESS_CONTEXT: Failed to create an OpenGL " << major << "." << minor << " core context (EGL error 0x"
+            << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        if (eglContext != EGL_NO_CONTEXT)
+            eglDestroyContext(eglDisplay, eglContext);
+        eglTerminate(eglDisplay);
+        return false;
+    }
+    display = eglDisplay;
+    context = eglContext;
+    return true;
+#else
+    std::cout << "ERROR::HEADLESS_CONTEXT: No surfaceless context on this platform" << std::endl;
+    return false;
+#endif
+}
+
+void HeadlessContext::Destroy()
+{
+#if defined(__linux__)
+    if (context == nullptr)
+        return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+#endif
+    display = nullptr;
+    context = nullptr;
+}
+
+void *HeadlessContext::GetProcAddress(const char *name)
+{
+#if defined(__linux__)
+    // Mesa returns core functions too (EGL 1.5 / EGL_KHR_get_all_proc_addresses)
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+#else
+    return nullptr;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+
+// A static singleton owning an OpenGL context that has no window and
+// no display connection at all: on Linux an EGL context on Mesa's
+// surfaceless platform (EGL_PLATFORM_SURFACELESS_MESA, e.g. llvmpipe
+// on a CI machine without X or Wayland), made current without any
+// surface (EGL_NO_SURFACE). Rendering has to go to a framebuffer
+// object. Other platforms have no such context and Create fails.
+class HeadlessContext
+{
+public:
+    // creates a major.minor core profile context and makes it current on the calling thread
+    static bool  Create(int major, int minor);
+    // releases and destroys the context
+    static void  Destroy();
+    // true between a successful Create and Destroy
+    static bool  Current() { return context != nullptr; }
+    // GL entry point lookup, for gladLoadGLLoader
+    static void *GetProcAddress(const char *name);
+private:
+    // private constructor, that is we do not want any actual headless context objects. Its members and functions should be publicly available (static).
+    HeadlessContext() { }
+    static void *display;
+    static void *context;
+};
+
+#endif
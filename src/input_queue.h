@@ -0,0 +1,68 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <atomic>
+
+
+// A key press or release as seen by the GLFW key callback
+struct InputEvent
+{
+    double         Time;     // glfwGetTime() when the callback ran
+    unsigned short Key;
+    bool           Pressed;  // false for a release
+};
+
+// Hands input events from one producer thread (the one polling GLFW)
+// to one consumer thread (the one simulating) without locks. Events
+// sit in a fixed ring in the order they happened; head and tail only
+// ever grow and wrap around in the ring, and each is written by one
+// side only, so a Push and a Pop never contend for anything but the
+// cache lines the two counters live on.
+class InputQueue
+{
+public:
+    // number of events the ring holds, a power of two
+    static const unsigned int CAPACITY = 256;
+    InputQueue() : head(0), tail(0), dropped(0) { }
+    // producer: appends an event; returns false, and counts it as dropped, if the ring is full
+    bool Push(const InputEvent &event)
+    {
+        unsigned int head = this->head.load(std::memory_order_relaxed);
+        if (head - this->tail.load(std::memory_order_acquire) == CAPACITY)
+        {
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        this->events[head & (CAPACITY - 1)] = event;
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    // consumer: copies the oldest event without removing it; returns false if there is none
+    bool Peek(InputEvent &event) const
+    {
+        unsigned int tail = this->tail.load(std::memory_order_relaxed);
+        if (tail == this->head.load(std::memory_order_acquire))
+            return false;
+        event = this->events[tail & (CAPACITY - 1)];
+        return true;
+    }
+    // consumer: removes the event the last successful Peek returned
+    void Pop() { this->tail.store(this->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+    // events lost because the consumer fell CAPACITY events behind
+    unsigned int Dropped() const { return this->dropped.load(std::memory_order_relaxed); }
+private:
+    InputEvent                            events[CAPACITY];
+    alignas(64) std::atomic<unsigned int> head;    // producer only
+    alignas(64) std::atomic<unsigned int> tail;    // consumer only
+    std::atomic<unsigned int>             dropped;
+};
+
+#endif
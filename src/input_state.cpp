@@ -0,0 +1,61 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "input_state.h"
+
+#include <algorithm>
+
+
+InputState::InputState()
+    : downSince(), heldBefore(), tickStart(0.0), tickEnd(0.0)
+{
+
+}
+
+void InputState::Advance(InputQueue &queue, double time)
+{
+    this->pressed.reset();
+    this->released.reset();
+    for (unsigned short key : this->touched)
+        this->heldBefore[key] = 0.0;
+    this->touched.clear();
+    // tick times are derived from the clock anew every frame, never let them run backwards
+    this->tickStart = this->tickEnd;
+    this->tickEnd = std::max(time, this->tickEnd);
+
+    InputEvent event;
+    while (queue.Peek(event) && event.Time <= this->tickEnd)
+    {
+        queue.Pop();
+        if (event.Key >= MAX_KEYS)
+            continue;
+        if (event.Pressed && !this->held[event.Key])
+        {
+            this->held[event.Key] = true;
+            this->pressed[event.Key] = true;
+            this->downSince[event.Key] = event.Time;
+        }
+        else if (!event.Pressed && this->held[event.Key])
+        {
+            this->held[event.Key] = false;
+            this->released[event.Key] = true;
+            this->heldBefore[event.Key] += std::max(0.0, event.Time - std::max(this->downSince[event.Key], this->tickStart));
+            this->touched.push_back(event.Key);
+        }
+    }
+}
+
+double InputState::HeldSeconds(unsigned int key) const
+{
+    if (key >= MAX_KEYS)
+        return 0.0;
+    double seconds = this->heldBefore[key];
+    if (this->held[key])
+        seconds += this->tickEnd - std::max(this->downSince[key], this->tickStart);
+    return seconds;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef INPUT_STATE_H
+#define INPUT_STATE_H
+
+#include <bitset>
+#include <vector>
+
+#include "input_queue.h"
+
+
+// The keyboard as seen by one simulation tick. Advance consumes the
+// queued events up to the time the tick ends, so each press lands on
+// the tick it happened in: a key pressed and released again within a
+// tick still reports both edges, and HeldSeconds tells how much of the
+// tick a key was actually down, e.g. to move a paddle by exactly that
+// long instead of by whole ticks.
+class InputState
+{
+public:
+    // keys beyond this are ignored
+    static const unsigned int MAX_KEYS = 1024;
+    // constructor (all keys up)
+    InputState();
+    // starts a tick ending at time: consumes the events of queue up to it, later ones stay queued for later ticks
+    void   Advance(InputQueue &queue, double time);
+    // edges during the current tick
+    bool   Pressed(unsigned int key) const { return key < MAX_KEYS && this->pressed[key]; }
+    bool   Released(unsigned int key) const { return key < MAX_KEYS && this->released[key]; }
+    // down at the end of the current tick
+    bool   Held(unsigned int key) const { return key < MAX_KEYS && this->held[key]; }
+    // seconds of the current tick the key was down
+    double HeldSeconds(unsigned int key) const;
+    // when the key last went down (glfwGetTime seconds)
+    double PressTime(unsigned int key) const { return key < MAX_KEYS ? this->downSince[key] : 0.0; }
+private:
+    std::bitset<MAX_KEYS>       held, pressed, released;
+    double                      downSince[MAX_KEYS];
+    double                      heldBefore[MAX_KEYS];  // seconds of the tick spent down before the key's last release
+    std::vector<unsigned short> touched;              // keys with a heldBefore to reset on the next Advance
+    double                      tickStart, tickEnd;
+};
+
+#endif
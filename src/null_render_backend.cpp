@@ -0,0 +1,39 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "null_render_backend.h"
+#include "sprite_renderer.h"
+
+
+NullRenderBackend::NullRenderBackend()
+{
+    this->batch.reserve(SpriteRenderer::MAX_BATCH_INSTANCES);
+}
+
+void NullRenderBackend::Submit(const SpriteCommand &command)
+{
+    // same batch boundaries as SpriteRenderer
+    if (!this->batch.empty() && (command.Texture != this->batch.back().Texture || command.Target != this->batch.back().Target || this->batch.size() >= SpriteRenderer::MAX_BATCH_INSTANCES))
+        this->Flush();
+    this->batch.push_back(command);
+    this->stats.Sprites++;
+}
+
+void NullRenderBackend::SetBlend(BlendMode)
+{
+    this->Flush();
+    this->stats.BlendChanges++;
+}
+
+void NullRenderBackend::Flush()
+{
+    if (this->batch.empty())
+        return;
+    this->stats.DrawCalls++;
+    this->batch.clear();
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef NULL_RENDER_BACKEND_H
+#define NULL_RENDER_BACKEND_H
+
+#include <vector>
+
+#include "render_backend.h"
+
+
+// A RenderBackend that issues no GL calls. Sprites are recorded into
+// a batch and counted exactly like SpriteRenderer batches them (a new
+// draw call per texture change or full batch), so the game's update
+// and submission cost can be measured without a context or a driver
+// in the loop, and the counters still match what the GL backend draws.
+class NullRenderBackend : public RenderBackend
+{
+public:
+    // constructor
+    NullRenderBackend();
+    // records a sprite into the current batch
+    void Submit(const SpriteCommand &command) override;
+    // ends the current batch, then counts the blend change
+    void SetBlend(BlendMode blend) override;
+    // counts the current batch as a draw call and empties it
+    void Flush() override;
+    // the sprites recorded since the last Flush
+    const std::vector<SpriteCommand> &Batch() const { return this->batch; }
+private:
+    std::vector<SpriteCommand> batch;
+};
+
+#endif
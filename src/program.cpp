@@ -11,12 +11,28 @@
 
 #include "game.h"
 #include "resource_manager.h"
+#include "benchmarks.h"
+#include "gl_state.h"
+#include "program_cache.h"
+#include "frame_uniforms.h"
+#include "upload_context.h"
+#include "fixed_timestep.h"
+#include "simulation_thread.h"
+#include "headless_context.h"
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 // GLFW function declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
+// main loops
+void runWindowed(GLFWwindow *window, FixedTimestep &timestep, bool singleThread, double initStart);
+void runHeadless(FixedTimestep &timestep, unsigned int frames, double simSeconds);
+void runNull(FixedTimestep &timestep, unsigned int frames, double simSeconds);
 
 // The Width of the screen
 const unsigned int SCREEN_WIDTH = 800;
@@ -27,7 +43,66 @@ Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
 
 int main(int argc, char *argv[])
 {
-    glfwInit();
+    bool uploadThread = false;
+    bool singleThread = false;
+    bool headless = false;
+    bool nullRenderer = false;
+    unsigned int headlessFrames = 0;
+    double headlessSeconds = 0.0;
+    // the simulation runs at a fixed rate, independent of the display's
+    FixedTimestep timestep(60.0, 5);
+    // --bench runs the CPU microbenchmarks and exits without opening a window
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--bench") == 0)
+        {
+            RunBenchmarks();
+            return 0;
+        }
+        // --no-shader-cache compiles every program from source, e.g. to compare startup times
+        if (std::strcmp(argv[i], "--no-shader-cache") == 0)
+            ProgramBinaryCache::Enabled = false;
+        // --upload-thread moves texture uploads to a second, shared GL context
+        if (std::strcmp(argv[i], "--upload-thread") == 0)
+            uploadThread = true;
+        // --tick-rate N simulates N ticks per second (60 by default)
+        if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc && std::atof(argv[i + 1]) > 0.0)
+            timestep.SetTickRate(std::atof(argv[++i]));
+        // --single-thread simulates and renders on the main thread, one after the other, e.g. to compare frame times
+        if (std::strcmp(argv[i], "--single-thread") == 0)
+            singleThread = true;
+        // --headless renders offscreen without a display (surfaceless EGL or OSMesa), for --frames N or --sim-seconds S, and prints throughput
+        if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            headlessFrames = static_cast<unsigned int>(std::atoi(argv[++i]));
+        if (std::strcmp(argv[i], "--sim-seconds") == 0 && i + 1 < argc)
+            headlessSeconds = std::atof(argv[++i]);
+        // --null-renderer runs like --headless, but draws through the null backend without any GL context
+        if (std::strcmp(argv[i], "--null-renderer") == 0)
+            nullRenderer = true;
+    }
+    if ((headless || nullRenderer) && headlessFrames == 0 && headlessSeconds <= 0.0)
+        headlessFrames = 600;
+
+    // without GL there is no window, context or GL resource to set up or clean up
+    if (nullRenderer)
+    {
+        Breakout.Init(RENDER_BACKEND_NULL);
+        runNull(timestep, headlessFrames, headlessSeconds);
+        Breakout.Shutdown();
+        return 0;
+    }
+
+    // headless runs without any display connection: GLFW on its null platform (still needed for its timer),
+    // the context from surfaceless EGL (e.g. Mesa llvmpipe), or from OSMesa through GLFW if that is unavailable
+    if (headless)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (!glfwInit())
+    {
+        std::cout << "Failed to initialize GLFW" << std::endl;
+        return -1;
+    }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -37,89 +112,273 @@ int main(int argc, char *argv[])
     glfwWindowHint(GLFW_RESIZABLE, false);
 
 
-    GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Fox Game", nullptr, nullptr);
-    glfwMakeContextCurrent(window);
+    GLFWwindow* window = nullptr;
+    GLADloadproc loader = (GLADloadproc)glfwGetProcAddress;
+    if (headless && HeadlessContext::Create(3, 3))
+        loader = (GLADloadproc)HeadlessContext::GetProcAddress;
+    else
+    {
+        if (headless)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        }
+        window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Fox Game", nullptr, nullptr);
+        if (window == nullptr)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    }
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    if (!gladLoadGLLoader(loader))
     {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1; 
     }
 
-    glfwSetKeyCallback(window, key_callback);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
     // OpenGL configuration
     // --------------------
-    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::Invalidate();
+    GLState::Viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    GLState::Blend(true);
+    GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    FrameUniforms::Init();
+    // the upload context is created through GLFW, sharing the window's context; the surfaceless context has no window
+    if (uploadThread && window != nullptr)
+        UploadContext::Start(window);
 
     // initialize game
     // ---------------
+    double initStart = glfwGetTime();
     Breakout.Init();
+    std::cout << "Shader programs ready in " << ResourceManager::ShaderLoadSeconds * 1000.0 << " ms (binary cache "
+        << (ProgramBinaryCache::Enabled && ProgramBinaryCache::Supported() ? "on" : "off") << ": " << ProgramBinaryCache::Hits << " hits, "
+        << ProgramBinaryCache::Misses << " misses, " << ProgramBinaryCache::Rejects << " rejected)" << std::endl;
+    // rebuild shaders while the game runs whenever their sources are saved
+    if (!headless)
+        ResourceManager::WatchShaders();
+
+    // run the game until the window closes, or for the requested frames offscreen
+    // ---------------------------------------------------------------------------
+    if (headless)
+        runHeadless(timestep, headlessFrames, headlessSeconds);
+    else
+        runWindowed(window, timestep, singleThread, initStart);
+
+#ifndef NDEBUG
+    // how much the state cache filtered out, on average per frame
+    if (GLState::Frames() > 0)
+        std::cout << "GL state cache: " << GLState::Total().Issued / GLState::Frames() << " calls issued, "
+            << GLState::Total().Skipped / GLState::Frames() << " skipped per frame" << std::endl;
+#endif
+
+    // texel traffic of the atlas pages, which are updated through the pixel buffer ring
+    const TextureStreamer &streamer = ResourceManager::Atlas.Streamer();
+    std::cout << "Atlas uploads: " << streamer.TotalBytes() << " bytes streamed, at most " << streamer.PeakFrameBytes() << " bytes in one frame"
+        << (streamer.Ring() != nullptr ? ", " + std::to_string(streamer.Ring()->Stalls()) + " stalls" : std::string()) << std::endl;
+
+    // delete the game's renderer and all resources as loaded using the resource manager
+    // ---------------------------------------------------------------------------------
+    UploadContext::Stop();
+    Breakout.Shutdown();
+    ResourceManager::Clear();
+    FrameUniforms::Clear();
+
+    HeadlessContext::Destroy();
+    glfwTerminate();
+    return 0;
+}
+
+void runWindowed(GLFWwindow *window, FixedTimestep &timestep, bool singleThread, double initStart)
+{
+    // reported once the textures Init started loading are all visible
+    bool texturesReady = false;
 
     // deltaTime variables
     // -------------------
-    float deltaTime = 0.0f;
-    float lastFrame = 0.0f;
+    double deltaTime = 0.0;
+    double lastFrame = glfwGetTime();
+
+    // the simulation ticks on its own thread, the main thread keeps the GL context and renders the latest snapshot
+    // ------------------------------------------------------------------------------------------------------------
+    SimulationThread simulation(Breakout, timestep);
+    GameSnapshot previous, current;
+    Breakout.Snapshot(current);
+    previous = current;
+    if (!singleThread)
+        simulation.Start();
+    StageTimings simulationTimings = {}, renderTimings = {}, frameTimings = {};
 
     while (!glfwWindowShouldClose(window))
     {
+        // poll first, so the input events are older than the frame time the ticks below end at
+        glfwPollEvents();
         // calculate delta time
         // --------------------
-        float currentFrame = glfwGetTime();
+        double currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-        glfwPollEvents();
-
-        // manage user input
-        // -----------------
-        Breakout.ProcessInput(deltaTime);
+        frameTimings.Add(deltaTime);
+        ResourceManager::UpdateShaders();
+        // publish textures whose upload thread fences signaled, then upload (or hand over) the ones
+        // the loader threads finished decoding, spending at most 2 ms of the frame on it
+        UploadContext::Poll();
+        ResourceManager::FinalizeLoads(0.002);
+        if (!texturesReady && ResourceManager::PendingLoads() == 0)
+        {
+            texturesReady = true;
+            std::cout << "Textures ready " << (glfwGetTime() - initStart) * 1000.0 << " ms after Init (" << ResourceManager::CookedTextureLoads
+                << " cooked, " << ResourceManager::DecodedTextureLoads << " decoded)" << std::endl;
+        }
 
-        // update game state
-        // -----------------
-        Breakout.Update(deltaTime);
+        // manage user input and update game state, in as many fixed ticks as the frame's time covers
+        // ------------------------------------------------------------------------------------------
+        if (singleThread)
+        {
+            unsigned int ticks = timestep.Advance(deltaTime);
+            for (unsigned int tick = 0; tick < ticks; ++tick)
+            {
+                auto tickStart = std::chrono::steady_clock::now();
+                previous = current;
+                Breakout.ProcessInput(static_cast<float>(timestep.Step()), timestep.TickTime(currentFrame, tick, ticks));
+                Breakout.Update(static_cast<float>(timestep.Step()));
+                Breakout.Snapshot(current);
+                simulationTimings.Add(std::chrono::duration<double>(std::chrono::steady_clock::now() - tickStart).count());
+            }
+        }
 
-        // render
-        // ------
+        // render (timed up to the swap, which waits for the display)
+        // ----------------------------------------------------------
+        auto renderStart = std::chrono::steady_clock::now();
+        FrameUniforms::SetTime(static_cast<float>(currentFrame));
+        FrameUniforms::Upload();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        Breakout.Render();
+        if (singleThread)
+            Breakout.Render(previous, current, timestep.Alpha());
+        else if (simulation.Acquire())
+            Breakout.Render(simulation.Frame().Previous, simulation.Frame().Current, simulation.Alpha(glfwGetTime()));
+        renderTimings.Add(std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count());
 
         glfwSwapBuffers(window);
+        GLState::EndFrame();
     }
 
-    // delete all resources as loaded using the resource manager
-    // ---------------------------------------------------------
-    ResourceManager::Clear();
+    simulation.Stop();
 
-    glfwTerminate();
-    return 0;
+    // per stage CPU time; threaded, a frame costs the larger of the two instead of their sum
+    const FixedTimestep &ticked = singleThread ? timestep : simulation.Timestep();
+    const StageTimings &simulated = singleThread ? simulationTimings : simulation.Timings();
+    std::cout << "Simulation (" << (singleThread ? "main thread" : "own thread") << "): " << ticked.Ticks() << " ticks at " << 1.0 / ticked.Step() << " Hz, "
+        << simulated.AverageMilliseconds() << " ms/tick (max " << simulated.MaxSeconds * 1000.0 << "), " << ticked.DroppedSeconds() << " s dropped after hitches" << std::endl;
+    std::cout << "Render: " << renderTimings.AverageMilliseconds() << " ms/frame (max " << renderTimings.MaxSeconds * 1000.0 << "), "
+        << frameTimings.AverageMilliseconds() << " ms between frames" << std::endl;
 }
 
-void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
+void runHeadless(FixedTimestep &timestep, unsigned int frames, double simSeconds)
 {
-    // when a user presses the escape key, we set the WindowShouldClose property to true, closing the application
-    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-    if (key >= 0 && key < 1024)
+    // an offscreen framebuffer stands in for the window's
+    unsigned int colorBuffer, framebuffer;
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::HEADLESS: Offscreen framebuffer is incomplete" << std::endl;
+    else
     {
-        if (action == GLFW_PRESS)
-            Breakout.Keys[key] = true;
-        else if (action == GLFW_RELEASE)
+        // every run starts from the same, fully loaded state
+        ResourceManager::FinishLoads();
+        GameSnapshot previous, current;
+        Breakout.Snapshot(current);
+        previous = current;
+        // each frame advances exactly one tick of simulated time, so runs are reproducible and go as fast as the machine allows
+        unsigned int frame = 0;
+        double simulated = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        while ((frames == 0 || frame < frames) && (simSeconds <= 0.0 || simulated < simSeconds))
         {
-            Breakout.Keys[key] = false;
-//            Breakout.KeysProcessed[key] = false;
+            unsigned int ticks = timestep.Advance(timestep.Step());
+            for (unsigned int tick = 0; tick < ticks; ++tick)
+            {
+                previous = current;
+                Breakout.ProcessInput(static_cast<float>(timestep.Step()), timestep.TickTime(simulated + timestep.Step(), tick, ticks));
+                Breakout.Update(static_cast<float>(timestep.Step()));
+                Breakout.Snapshot(current);
+            }
+            simulated += timestep.Step();
+            FrameUniforms::SetTime(static_cast<float>(simulated));
+            FrameUniforms::Upload();
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            Breakout.Render(previous, current, timestep.Alpha());
+            GLState::EndFrame();
+            ++frame;
         }
+        // count the GPU's share too, not just what was submitted
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Headless: " << frame << " frames, " << timestep.Ticks() << " ticks (" << simulated << " s simulated) in " << seconds << " s: "
+            << frame / seconds << " frames/s, " << timestep.Ticks() / seconds << " ticks/s (" << glGetString(GL_RENDERER) << ")" << std::endl;
     }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &colorBuffer);
+}
+
+void runNull(FixedTimestep &timestep, unsigned int frames, double simSeconds)
+{
+    GameSnapshot previous, current;
+    Breakout.Snapshot(current);
+    previous = current;
+    // the same frames as runHeadless, minus everything GL
+    unsigned int frame = 0;
+    double simulated = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    while ((frames == 0 || frame < frames) && (simSeconds <= 0.0 || simulated < simSeconds))
+    {
+        unsigned int ticks = timestep.Advance(timestep.Step());
+        for (unsigned int tick = 0; tick < ticks; ++tick)
+        {
+            previous = current;
+            Breakout.ProcessInput(static_cast<float>(timestep.Step()), timestep.TickTime(simulated + timestep.Step(), tick, ticks));
+            Breakout.Update(static_cast<float>(timestep.Step()));
+            Breakout.Snapshot(current);
+        }
+        simulated += timestep.Step();
+        Breakout.Render(previous, current, timestep.Alpha());
+        ++frame;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const RenderBackendStats &stats = Breakout.RenderStats();
+    std::cout << "Null renderer: " << frame << " frames, " << timestep.Ticks() << " ticks (" << simulated << " s simulated) in " << seconds << " s: "
+        << frame / seconds << " frames/s, " << timestep.Ticks() / seconds << " ticks/s; " << stats.Sprites << " sprites in "
+        << stats.DrawCalls << " draw calls, " << stats.BlendChanges << " blend changes" << std::endl;
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
+{
+    // when a user presses the escape key, we set the WindowShouldClose property to true, closing the application
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    // queued with the time they were seen; the simulation consumes them on the tick they fall into
+    if (key >= 0 && key < static_cast<int>(InputState::MAX_KEYS) && action != GLFW_REPEAT)
+        Breakout.Events.Push({ glfwGetTime(), static_cast<unsigned short>(key), action == GLFW_PRESS });
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    GLState::Viewport(0, 0, width, height);
+    FrameUniforms::SetResolution(static_cast<float>(width), static_cast<float>(height));
 }
\ No newline at end of file
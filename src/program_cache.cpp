@@ -0,0 +1,137 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "program_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "hash.h"
+
+
+namespace
+{
+    // header in front of every cached binary
+    struct CacheHeader
+    {
+        std::uint32_t Magic;
+        std::uint32_t Format;
+        std::uint32_t Length;
+        std::uint32_t Reserved;
+        std::uint64_t Key;
+    };
+    const std::uint32_t CACHE_MAGIC = 0x48435042; // "BPCH"
+
+    std::uint64_t hashString(const char *text, std::uint64_t hash)
+    {
+        // the terminating zero separates consecutive strings, so "ab"+"c" and "a"+"bc" differ
+        if (text == nullptr)
+            return Fnv1a64("", 1, hash);
+        return Fnv1a64(text, std::strlen(text) + 1, hash);
+    }
+}
+
+// Instantiate static variables
+std::string  ProgramBinaryCache::Directory = "shader_cache";
+bool         ProgramBinaryCache::Enabled = true;
+unsigned int ProgramBinaryCache::Hits = 0;
+unsigned int ProgramBinaryCache::Misses = 0;
+unsigned int ProgramBinaryCache::Rejects = 0;
+
+
+bool ProgramBinaryCache::Supported()
+{
+    if (!GLAD_GL_VERSION_4_1)
+        return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+std::uint64_t ProgramBinaryCache::Key(const char *vertexSource, const char *fragmentSource, const char *geometrySource)
+{
+    std::uint64_t hash = hashString(vertexSource, Fnv1a64("", 0));
+    hash = hashString(fragmentSource, hash);
+    hash = hashString(geometrySource, hash);
+    hash = hashString(reinterpret_cast<const char*>(glGetString(GL_VENDOR)), hash);
+    hash = hashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), hash);
+    return hashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), hash);
+}
+
+bool ProgramBinaryCache::Load(std::uint64_t key, Shader &shader)
+{
+    if (!Enabled || !Supported())
+        return false;
+    std::string entry = path(key);
+    std::ifstream file(entry, std::ios::binary);
+    CacheHeader header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.Magic != CACHE_MAGIC || header.Key != key)
+    {
+        Misses++;
+        return false;
+    }
+    // a corrupt or truncated entry must not make us allocate whatever its header claims
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(entry, error);
+    if (error || header.Length == 0 || header.Length > size - sizeof(header))
+    {
+        Rejects++;
+        return false;
+    }
+    std::vector<char> binary(header.Length);
+    if (!file.read(binary.data(), binary.size()) || !shader.LoadBinary(header.Format, binary.data(), static_cast<GLsizei>(binary.size())))
+    {
+        // typically a driver update that kept the version string; the fresh compile overwrites the entry
+        Rejects++;
+        return false;
+    }
+    Hits++;
+    return true;
+}
+
+void ProgramBinaryCache::Store(std::uint64_t key, const Shader &shader)
+{
+    if (!Enabled || !Supported())
+        return;
+    GLenum format = 0;
+    std::vector<char> binary;
+    if (!shader.GetBinary(format, binary))
+        return;
+    std::error_code error;
+    std::filesystem::create_directories(Directory, error);
+    // write to a temporary first, so a crash never leaves a truncated entry behind
+    std::string target = path(key);
+    std::string temporary = target + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        CacheHeader header = { CACHE_MAGIC, format, static_cast<std::uint32_t>(binary.size()), 0, key };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), binary.size());
+        if (!file)
+        {
+            std::cout << "WARNING::PROGRAM_CACHE: Failed to write " << temporary << std::endl;
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, target, error);
+    if (error)
+        std::cout << "WARNING::PROGRAM_CACHE: Failed to store " << target << ": " << error.message() << std::endl;
+}
+
+std::string ProgramBinaryCache::path(std::uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return Directory + "/" + name;
+}
\ No newline at end of file
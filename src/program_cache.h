@@ -0,0 +1,49 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include "shader.h"
+
+
+// A static singleton that stores linked shader programs on disk with
+// glGetProgramBinary and restores them with glProgramBinary, so later
+// launches skip compiling and linking. Entries are keyed by a hash of
+// all stage sources and the driver's vendor, renderer and version
+// strings; a driver update therefore simply misses the old entries.
+// A binary the driver rejects counts as a miss and is replaced after
+// the regular compile.
+class ProgramBinaryCache
+{
+public:
+    // directory cache entries are written to
+    static std::string Directory;
+    // set to false (--no-shader-cache) to always compile from source
+    static bool        Enabled;
+    // counters since startup
+    static unsigned int Hits, Misses, Rejects;
+    // true if the driver can save and load program binaries at all
+    static bool          Supported();
+    // computes the cache key of a program from its sources (geometrySource may be nullptr)
+    static std::uint64_t Key(const char *vertexSource, const char *fragmentSource, const char *geometrySource);
+    // loads the cached program for key into shader; false on a miss or a rejected binary
+    static bool          Load(std::uint64_t key, Shader &shader);
+    // writes the binary of a freshly linked shader under key
+    static void          Store(std::uint64_t key, const Shader &shader);
+private:
+    // private constructor, that is we do not want any actual cache objects. Its members and functions should be publicly available (static).
+    ProgramBinaryCache() { }
+    // file the entry for key lives in
+    static std::string path(std::uint64_t key);
+};
+
+#endif
@@ -0,0 +1,90 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RENDER_BACKEND_H
+#define RENDER_BACKEND_H
+
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+#include "texture_atlas.h"
+
+
+// Blend state a sprite is drawn with
+enum BlendMode {
+    BLEND_ALPHA,         // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+    BLEND_ADDITIVE,      // GL_SRC_ALPHA, GL_ONE
+    BLEND_OPAQUE,        // blending disabled
+    BLEND_PREMULTIPLIED  // GL_ONE, GL_ONE_MINUS_SRC_ALPHA, for textures whose color is already multiplied by alpha
+};
+
+// One sprite draw
+struct SpriteCommand
+{
+    GLenum       Target;   // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+    unsigned int Texture;
+    float        Layer;    // array texture layer
+    glm::vec4    UVRect;
+    glm::vec2    Position, Size;
+    float        Rotate;
+    glm::vec3    Color;
+};
+
+// Counters of a RenderBackend since it was created
+struct RenderBackendStats
+{
+    std::uint64_t Sprites;
+    std::uint64_t DrawCalls;     // the null backend counts the ones the GL backend would issue
+    std::uint64_t BlendChanges;
+};
+
+// Which RenderBackend the game draws through
+enum RenderBackendType {
+    RENDER_BACKEND_GL,
+    RENDER_BACKEND_NULL
+};
+
+// Interface everything that draws goes through: SpriteRenderer issues
+// the commands with OpenGL, NullRenderBackend only records and counts
+// them and needs no GL context at all. Texture names in the commands
+// are passed on untouched, so the null backend accepts any value.
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() { }
+    // draws (or queues) a sprite
+    virtual void Submit(const SpriteCommand &command) = 0;
+    // sets the blend state of the following sprites; sprites still queued are drawn with the old one first
+    virtual void SetBlend(BlendMode blend) = 0;
+    // draws all queued sprites; call at least once at the end of every frame
+    virtual void Flush() = 0;
+    // counters since creation
+    const RenderBackendStats &Stats() const { return this->stats; }
+    // Renders a quad textured with the given texture
+    void DrawSprite(Texture2DView texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f))
+    {
+        this->Submit({ GL_TEXTURE_2D, texture.ID, 0.0f, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), position, size, rotate, color });
+    }
+    // Renders a quad textured with a region of an atlas page
+    void DrawSprite(const AtlasRegion &region, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f))
+    {
+        this->Submit({ GL_TEXTURE_2D, region.Texture, 0.0f, region.UVRect, position, size, rotate, color });
+    }
+    // Renders a quad textured with one layer of an array texture
+    void DrawSprite(Texture2DArrayView texture, unsigned int layer, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f))
+    {
+        this->Submit({ GL_TEXTURE_2D_ARRAY, texture.ID, static_cast<float>(layer), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), position, size, rotate, color });
+    }
+protected:
+    RenderBackendStats stats = {};
+};
+
+#endif
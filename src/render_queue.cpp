@@ -0,0 +1,158 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "render_queue.h"
+
+#include <algorithm>
+
+
+namespace
+{
+    const unsigned int DEPTH_BITS   = 24;
+    const unsigned int TEXTURE_BITS = 24;
+    const unsigned int SHADER_BITS  = 6;
+    const unsigned int BLEND_BITS   = 2;
+    const unsigned int LAYER_BITS   = 8;
+
+    inline std::uint64_t field(std::uint64_t value, unsigned int bits)
+    {
+        return value & ((std::uint64_t(1) << bits) - 1);
+    }
+
+    // the sprite programs are picked by texture target, so that is what the shader bits encode
+    inline unsigned int shaderIndex(GLenum target)
+    {
+        return target == GL_TEXTURE_2D_ARRAY ? 1 : 0;
+    }
+
+    inline unsigned int blendOf(std::uint64_t key)
+    {
+        return static_cast<unsigned int>(field(key >> (DEPTH_BITS + TEXTURE_BITS + SHADER_BITS), BLEND_BITS));
+    }
+
+    inline unsigned int shaderOf(std::uint64_t key)
+    {
+        return static_cast<unsigned int>(field(key >> (DEPTH_BITS + TEXTURE_BITS), SHADER_BITS));
+    }
+
+    inline unsigned int textureOf(std::uint64_t key)
+    {
+        return static_cast<unsigned int>(field(key >> DEPTH_BITS, TEXTURE_BITS));
+    }
+}
+
+RenderQueue::RenderQueue(RenderBackend &renderer)
+    : renderer(renderer), stats()
+{
+
+}
+
+void RenderQueue::DrawSprite(unsigned int layer, Texture2DView texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color, float depth, BlendMode blend)
+{
+    this->record(layer, blend == BLEND_ALPHA && texture.Premultiplied ? BLEND_PREMULTIPLIED : blend, { GL_TEXTURE_2D, texture.ID, 0.0f, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), position, size, rotate, color }, depth);
+}
+
+void RenderQueue::DrawSprite(unsigned int layer, const AtlasRegion &region, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color, float depth, BlendMode blend)
+{
+    this->record(layer, blend == BLEND_ALPHA && region.Premultiplied ? BLEND_PREMULTIPLIED : blend, { GL_TEXTURE_2D, region.Texture, 0.0f, region.UVRect, position, size, rotate, color }, depth);
+}
+
+void RenderQueue::DrawSprite(unsigned int layer, Texture2DArrayView texture, unsigned int arrayLayer, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color, float depth, BlendMode blend)
+{
+    this->record(layer, blend, { GL_TEXTURE_2D_ARRAY, texture.ID, static_cast<float>(arrayLayer), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), position, size, rotate, color }, depth);
+}
+
+void RenderQueue::Execute()
+{
+    this->stats = RenderQueueStats();
+    this->stats.Commands = static_cast<unsigned int>(this->commands.size());
+    // what the frame would have cost in recording order
+    unsigned int unsortedPrograms = 0, unsortedTextures = 0;
+    for (std::size_t i = 0; i < this->keys.size(); ++i)
+    {
+        if (i == 0 || shaderOf(this->keys[i]) != shaderOf(this->keys[i - 1]))
+            unsortedPrograms++;
+        if (i == 0 || textureOf(this->keys[i]) != textureOf(this->keys[i - 1]) || shaderOf(this->keys[i]) != shaderOf(this->keys[i - 1]))
+            unsortedTextures++;
+    }
+
+    this->sort();
+
+    unsigned int blend = BLEND_ALPHA;
+    for (std::size_t i = 0; i < this->order.size(); ++i)
+    {
+        std::uint64_t key = this->keys[i];
+        if (i == 0 || shaderOf(key) != shaderOf(this->keys[i - 1]))
+            this->stats.ProgramSwitches++;
+        if (i == 0 || textureOf(key) != textureOf(this->keys[i - 1]) || shaderOf(key) != shaderOf(this->keys[i - 1]))
+            this->stats.TextureSwitches++;
+        if (blendOf(key) != blend)
+        {
+            // the backend draws what it queued under the old blend state first
+            blend = blendOf(key);
+            this->renderer.SetBlend(static_cast<BlendMode>(blend));
+            this->stats.BlendSwitches++;
+        }
+        this->renderer.Submit(this->commands[this->order[i]]);
+    }
+    this->renderer.Flush();
+    // leave the default blend state behind for code that doesn't go through the queue
+    if (blend != BLEND_ALPHA)
+        this->renderer.SetBlend(BLEND_ALPHA);
+
+    this->stats.ProgramSwitchesSaved = static_cast<int>(unsortedPrograms) - static_cast<int>(this->stats.ProgramSwitches);
+    this->stats.TextureSwitchesSaved = static_cast<int>(unsortedTextures) - static_cast<int>(this->stats.TextureSwitches);
+    this->commands.clear();
+    this->keys.clear();
+    this->order.clear();
+}
+
+void RenderQueue::record(unsigned int layer, BlendMode blend, const SpriteCommand &command, float depth)
+{
+    std::uint64_t quantizedDepth = static_cast<std::uint64_t>(glm::clamp(depth, 0.0f, 1.0f) * ((1 << DEPTH_BITS) - 1));
+    std::uint64_t key = field(layer, LAYER_BITS);
+    key = (key << BLEND_BITS) | field(blend, BLEND_BITS);
+    key = (key << SHADER_BITS) | field(shaderIndex(command.Target), SHADER_BITS);
+    key = (key << TEXTURE_BITS) | field(command.Texture, TEXTURE_BITS);
+    key = (key << DEPTH_BITS) | field(quantizedDepth, DEPTH_BITS);
+    this->order.push_back(static_cast<std::uint32_t>(this->commands.size()));
+    this->keys.push_back(key);
+    this->commands.push_back(command);
+}
+
+void RenderQueue::sort()
+{
+    std::size_t count = this->keys.size();
+    this->scratchKeys.resize(count);
+    this->scratchOrder.resize(count);
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        std::size_t offsets[256] = {};
+        for (std::uint64_t key : this->keys)
+            offsets[(key >> shift) & 0xFF]++;
+        // a byte that is the same in every key can't change the order, skip the pass
+        if (count == 0 || offsets[(this->keys[0] >> shift) & 0xFF] == count)
+            continue;
+        std::size_t sum = 0;
+        for (std::size_t &offset : offsets)
+        {
+            std::size_t bucket = offset;
+            offset = sum;
+            sum += bucket;
+        }
+        // stable scatter keeps the order of the previous, less significant passes
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t destination = offsets[(this->keys[i] >> shift) & 0xFF]++;
+            this->scratchKeys[destination] = this->keys[i];
+            this->scratchOrder[destination] = this->order[i];
+        }
+        std::swap(this->keys, this->scratchKeys);
+        std::swap(this->order, this->scratchOrder);
+    }
+}
\ No newline at end of file
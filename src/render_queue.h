@@ -0,0 +1,72 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "render_backend.h"
+#include "texture.h"
+#include "texture_atlas.h"
+
+
+// Per-frame counters of a RenderQueue. The *Saved fields are the
+// switches the frame would have caused in recording order minus the
+// ones it caused after sorting; they go negative when sorting by layer
+// first splits draws that recording order had kept together.
+struct RenderQueueStats
+{
+    unsigned int Commands;
+    unsigned int ProgramSwitches;
+    unsigned int TextureSwitches;
+    unsigned int BlendSwitches;
+    int          ProgramSwitchesSaved;
+    int          TextureSwitchesSaved;
+};
+
+// Records sprite draws for a frame instead of issuing them right
+// away. Every command gets a 64-bit sort key, packed from the most to
+// the least significant bits as
+//   layer (8) | blend mode (2) | shader (6) | texture (24) | depth (24)
+// and Execute radix sorts the keys once, then submits the commands to
+// the RenderBackend in key order so draws sharing a program and a
+// texture end up next to each other (and thus in one batch).
+class RenderQueue
+{
+public:
+    // constructor, commands are executed through renderer
+    RenderQueue(RenderBackend &renderer);
+    // records a sprite; lower layers are drawn first, depth (0..1) orders sprites sharing all other state.
+    // BLEND_ALPHA sprites of premultiplied textures are drawn with BLEND_PREMULTIPLIED
+    void DrawSprite(unsigned int layer, Texture2DView texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), float depth = 0.0f, BlendMode blend = BLEND_ALPHA);
+    void DrawSprite(unsigned int layer, const AtlasRegion &region, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), float depth = 0.0f, BlendMode blend = BLEND_ALPHA);
+    void DrawSprite(unsigned int layer, Texture2DArrayView texture, unsigned int arrayLayer, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), float depth = 0.0f, BlendMode blend = BLEND_ALPHA);
+    // sorts and submits all recorded commands, flushes the renderer and starts a new frame
+    void Execute();
+    // counters of the last executed frame
+    const RenderQueueStats &Stats() const { return this->stats; }
+private:
+    RenderBackend              &renderer;
+    std::vector<SpriteCommand> commands;
+    std::vector<std::uint64_t> keys;
+    std::vector<std::uint32_t> order;      // command indices, sorted alongside keys
+    std::vector<std::uint64_t> scratchKeys;
+    std::vector<std::uint32_t> scratchOrder;
+    RenderQueueStats           stats;
+    // records a command under its packed key
+    void record(unsigned int layer, BlendMode blend, const SpriteCommand &command, float depth);
+    // LSD radix sort of keys (and order), one byte per pass
+    void sort();
+};
+
+#endif
@@ -8,93 +8,513 @@
 ******************************************************************/
 #include "resource_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <fstream>
 
 #include "stb_image.h"
+#include "gl_state.h"
+#include "program_cache.h"
+#include "upload_context.h"
 
 // Instantiate static variables
-std::map<std::string, Texture2D>    ResourceManager::Textures;
-std::map<std::string, Shader>       ResourceManager::Shaders;
+ResourceRegistry<Texture2D>         ResourceManager::Textures;
+ResourceRegistry<Shader>            ResourceManager::Shaders;
+ResourceRegistry<Texture2DArray>    ResourceManager::TextureArrays;
+ResourceRegistry<AtlasRegion>       ResourceManager::AtlasRegions;
+TextureAtlas                        ResourceManager::Atlas;
+double                              ResourceManager::ShaderLoadSeconds = 0.0;
+unsigned int                        ResourceManager::CookedTextureLoads = 0;
+unsigned int                        ResourceManager::DecodedTextureLoads = 0;
+bool                                ResourceManager::shaderBatch = false;
+bool                                ResourceManager::parallelShaders = false;
+std::vector<std::pair<std::uint64_t, ResourceHandle<Shader>>> ResourceManager::pendingShaders;
+Shader                              ResourceManager::missingShader;
+std::map<std::string, ResourceManager::ShaderSource> ResourceManager::shaderSources;
+std::map<std::string, std::vector<std::string>> ResourceManager::shaderVariants;
+FileWatcher                        *ResourceManager::shaderWatcher = nullptr;
+std::vector<ResourceManager::ShaderReload> ResourceManager::shaderReloads;
+std::mutex                          ResourceManager::shaderCodeMutex;
+std::vector<ResourceManager::ShaderCode> ResourceManager::shaderCode;
+ThreadPool                         *ResourceManager::loaders = nullptr;
+std::mutex                          ResourceManager::decodedMutex;
+std::deque<ResourceManager::DecodedImage> ResourceManager::decoded;
+unsigned int                        ResourceManager::pendingLoads = 0;
 
 
-Shader ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
+Shader &ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
 {
-    Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
-    return Shaders[name];
+    return LoadShader(vShaderFile, fShaderFile, gShaderFile, std::vector<std::string>(), name);
 }
 
-Shader ResourceManager::GetShader(std::string name)
+Shader &ResourceManager::LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, const std::vector<std::string> &defines, std::string name)
 {
-    return Shaders[name];
+    ResourceHandle<Shader> handle = Shaders.Insert(name);
+    if (!handle.Valid())
+        return missingShader;
+    // remember the sources so the shader can be rebuilt when one of them (or anything they include) changes
+    ShaderSource &source = shaderSources[name];
+    source.Files.assign({ vShaderFile, fShaderFile });
+    if (gShaderFile != nullptr)
+        source.Files.push_back(gShaderFile);
+    source.Defines = defines;
+    std::uint64_t pendingKey = 0;
+    Shaders[handle] = loadShaderFromFile(source, shaderBatch ? &pendingKey : nullptr);
+    if (pendingKey != 0)
+        pendingShaders.push_back(std::make_pair(pendingKey, handle));
+    return Shaders[handle];
 }
 
-Texture2D ResourceManager::LoadTexture(const char *file, bool alpha, std::string name)
+void ResourceManager::RegisterShaderVariants(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
 {
-    Textures[name] = loadTextureFromFile(file, alpha);
-    return Textures[name];
+    std::vector<std::string> &files = shaderVariants[name];
+    files.assign({ vShaderFile, fShaderFile });
+    if (gShaderFile != nullptr)
+        files.push_back(gShaderFile);
+}
+
+Shader &ResourceManager::GetShaderVariant(const std::string &name, std::vector<std::string> defines)
+{
+    // the same set of defines in any order is the same permutation
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+    std::string key = name;
+    for (const std::string &define : defines)
+        key += "+" + define;
+    // by name, not just by hash: a key sharing the hash of another shader must not get that program
+    ResourceHandle<Shader> shader = Shaders.Find(key);
+    if (shader.Valid())
+        return Shaders[shader];
+    auto variants = shaderVariants.find(name);
+    if (variants == shaderVariants.end())
+    {
+        std::cout << "ERROR::SHADER: No shader variants registered as " << name << std::endl;
+        return missingShader;
+    }
+    const std::vector<std::string> &files = variants->second;
+    Shader &variant = LoadShader(files[0].c_str(), files[1].c_str(), files.size() > 2 ? files[2].c_str() : nullptr, defines, key);
+    if (&variant == &missingShader)
+        return variant;
+    // a permutation built after WatchShaders may depend on files nobody watches yet; restarting the
+    // watcher is only worth it then, permutations of one shader usually share all their sources
+    if (shaderWatcher != nullptr)
+    {
+        for (const std::string &file : shaderSources[key].Dependencies)
+        {
+            if (!shaderWatcher->IsWatched(file))
+            {
+                WatchShaders();
+                break;
+            }
+        }
+    }
+    return variant;
+}
+
+void ResourceManager::WatchShaders()
+{
+    delete shaderWatcher;
+    std::vector<std::string> files;
+    for (auto &shader : shaderSources)
+        for (const std::string &file : shader.second.Dependencies)
+            if (std::find(files.begin(), files.end(), file) == files.end())
+                files.push_back(file);
+    shaderWatcher = new FileWatcher(files);
+    if (shaderWatcher->IsWatching())
+        std::cout << "Watching " << files.size() << " shader sources for changes" << std::endl;
+}
+
+void ResourceManager::UpdateShaders()
+{
+    // the common case is a single atomic load: nothing changed and nothing is compiling
+    if (shaderWatcher != nullptr && shaderWatcher->HasChanges())
+    {
+        std::vector<std::string> changes = shaderWatcher->TakeChanges();
+        for (auto &shader : shaderSources)
+        {
+            const std::vector<std::string> &files = shader.second.Dependencies;
+            if (std::find_first_of(files.begin(), files.end(), changes.begin(), changes.end()) == files.end())
+                continue;
+            // a rebuild still in flight is outdated now
+            shaderReloads.erase(std::remove_if(shaderReloads.begin(), shaderReloads.end(), [&](const ShaderReload &reload) { return reload.Name == shader.first; }), shaderReloads.end());
+            // the files are read on a loader thread, the GL thread only submits the compile
+            if (loaders == nullptr)
+                loaders = new ThreadPool();
+            ShaderSource source = shader.second;
+            source.Revision = ++shader.second.Revision;
+            std::string name = shader.first;
+            loaders->Submit([source, name]()
+            {
+                ShaderCode code = readShaderCode(source);
+                code.Name = name;
+                std::lock_guard<std::mutex> lock(shaderCodeMutex);
+                shaderCode.push_back(std::move(code));
+            });
+        }
+    }
+    std::vector<ShaderCode> read;
+    {
+        std::lock_guard<std::mutex> lock(shaderCodeMutex);
+        read.swap(shaderCode);
+    }
+    for (ShaderCode &code : read)
+    {
+        auto source = shaderSources.find(code.Name);
+        if (source == shaderSources.end() || source->second.Revision != code.Revision)
+            continue;
+        source->second.Dependencies = code.Dependencies;
+        ShaderReload reload;
+        reload.Name = code.Name;
+        reload.Key = 0;
+        reload.Program = buildShader(code, &reload.Key);
+        reload.Submitted = true;
+        shaderReloads.push_back(std::move(reload));
+    }
+    for (auto reload = shaderReloads.begin(); reload != shaderReloads.end(); )
+    {
+        // with parallel compile the driver builds in the background, don't wait for it; without it Finish
+        // compiles on this thread, so give a fresh submit a frame and finish at most one program per frame
+        if (reload->Submitted || !reload->Program.IsReady())
+        {
+            reload->Submitted = false;
+            ++reload;
+            continue;
+        }
+        Shader &shader = Shaders[Shaders.Find(reload->Name)];
+        if (shader.Replace(reload->Program))
+        {
+            if (reload->Key != 0)
+                ProgramBinaryCache::Store(reload->Key, shader);
+            std::cout << "Reloaded shader " << reload->Name << std::endl;
+        }
+        else
+            std::cout << "ERROR::SHADER: Failed to rebuild shader " << reload->Name << ", keeping the old program" << std::endl;
+        reload = shaderReloads.erase(reload);
+        if (!parallelShaders)
+            break;
+    }
+}
+
+void ResourceManager::BeginShaderBatch()
+{
+    parallelShaders = Shader::EnableParallelCompile();
+    shaderBatch = true;
+    pendingShaders.clear();
+}
+
+void ResourceManager::EndShaderBatch()
+{
+    shaderBatch = false;
+    // this is the batch's only sync point: every status query below may wait for the driver
+    auto start = std::chrono::steady_clock::now();
+    for (auto &pending : pendingShaders)
+    {
+        Shader &shader = Shaders[pending.second];
+        if (shader.Finish())
+            ProgramBinaryCache::Store(pending.first, shader);
+        else
+            std::cout << "ERROR::SHADER: Failed to build shader " << Shaders.Name(pending.second) << std::endl;
+    }
+    double waitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ShaderLoadSeconds += waitSeconds;
+    std::cout << "Shader batch: " << pendingShaders.size() << " programs compiled, " << waitSeconds * 1000.0 << " ms waiting for the driver (parallel compile " << (parallelShaders ? "on" : "off") << ")" << std::endl;
+    pendingShaders.clear();
+}
+
+Shader &ResourceManager::GetShader(const std::string &name)
+{
+    ResourceHandle<Shader> handle = Shaders.Find(name);
+    return handle.Valid() ? Shaders[handle] : missingShader;
 }
 
-Texture2D ResourceManager::GetTexture(std::string name)
+const Texture2D &ResourceManager::LoadTexture(const char *file, bool alpha, std::string name)
+{
+    ResourceHandle<Texture2D> handle = Textures.Insert(name);
+    if (!handle.Valid())
+        return Textures.Fallback;
+    Textures[handle] = loadTextureFromFile(file, alpha);
+    return Textures[handle];
+}
+
+const Texture2D &ResourceManager::GetTexture(const std::string &name)
 {
     return Textures[name];
 }
 
-void ResourceManager::Clear()
+const Texture2DArray &ResourceManager::LoadTextureArray(const std::vector<std::string> &files, bool alpha, std::string name)
 {
-    // (properly) delete all shaders	
-    for (auto iter : Shaders)
-        glDeleteProgram(iter.second.ID);
-    // (properly) delete all textures
-    for (auto iter : Textures)
-        glDeleteTextures(1, &iter.second.ID);
-}
-
-Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile)
-{
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::string geometryCode;
-    try
-    {
-        // open files
-        std::ifstream vertexShaderFile(vShaderFile);
-        std::ifstream fragmentShaderFile(fShaderFile);
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vertexShaderFile.rdbuf();
-        fShaderStream << fragmentShaderFile.rdbuf();
-        // close file handlers
-        vertexShaderFile.close();
-        fragmentShaderFile.close();
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-        // if geometry shader path is present, also load a geometry shader
-        if (gShaderFile != nullptr)
+    ResourceHandle<Texture2DArray> handle = TextureArrays.Insert(name);
+    if (!handle.Valid())
+        return TextureArrays.Fallback;
+    Texture2DArray texture;
+    if (alpha)
+    {
+        texture.Internal_Format = GL_RGBA;
+        texture.Image_Format = GL_RGBA;
+    }
+    // decode every layer into one contiguous buffer, forcing a common channel count
+    int channels = alpha ? 4 : 3;
+    int layerWidth = 0, layerHeight = 0;
+    std::vector<unsigned char> pixels;
+    for (const std::string &file : files)
+    {
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(file.c_str(), &width, &height, &nrChannels, channels);
+        if (data == nullptr)
+        {
+            std::cout << "ERROR::TEXTURE: Failed to load " << file << std::endl;
+            continue;
+        }
+        if (pixels.empty())
         {
-            std::ifstream geometryShaderFile(gShaderFile);
-            std::stringstream gShaderStream;
-            gShaderStream << geometryShaderFile.rdbuf();
-            geometryShaderFile.close();
-            geometryCode = gShaderStream.str();
+            layerWidth = width;
+            layerHeight = height;
         }
+        if (width != layerWidth || height != layerHeight)
+            std::cout << "ERROR::TEXTURE: " << file << " is " << width << "x" << height << ", array " << name << " needs " << layerWidth << "x" << layerHeight << std::endl;
+        else
+            pixels.insert(pixels.end(), data, data + static_cast<size_t>(width) * height * channels);
+        stbi_image_free(data);
+    }
+    unsigned int layers = layerWidth > 0 ? static_cast<unsigned int>(pixels.size() / (static_cast<size_t>(layerWidth) * layerHeight * channels)) : 0;
+    texture.Generate(layerWidth, layerHeight, layers, pixels.empty() ? nullptr : pixels.data());
+    TextureArrays[handle] = std::move(texture);
+    return TextureArrays[handle];
+}
+
+const Texture2DArray &ResourceManager::GetTextureArray(const std::string &name)
+{
+    return TextureArrays[name];
+}
+
+const AtlasRegion &ResourceManager::LoadAtlasTexture(const char *file, std::string name)
+{
+    ResourceHandle<AtlasRegion> handle = AtlasRegions.Insert(name);
+    if (!handle.Valid())
+        return AtlasRegions.Fallback;
+    // a cooked RGBA file can be packed straight from the mapping
+    CookedTexture cooked(CookedTexture::CookedPath(file));
+    if (cooked.Valid() && cooked.Header().Channels == 4)
+    {
+        CookedTextureLoads++;
+        AtlasRegion &region = AtlasRegions[handle] = Atlas.Add(cooked.Header().Width, cooked.Header().Height, cooked.Level(0));
+        region.Premultiplied = (cooked.Header().Flags & BTEX_PREMULTIPLIED) != 0;
+        return region;
     }
-    catch (std::exception e)
+    // atlas pages are always RGBA, so let stb_image expand whatever the file holds
+    int width, height, nrChannels;
+    unsigned char* data = stbi_load(file, &width, &height, &nrChannels, 4);
+    if (data == nullptr)
     {
-        std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
+        std::cout << "ERROR::TEXTURE: Failed to load " << file << std::endl;
+        return AtlasRegions[handle];
     }
-    const char *vShaderCode = vertexCode.c_str();
-    const char *fShaderCode = fragmentCode.c_str();
-    const char *gShaderCode = geometryCode.c_str();
-    // 2. now create shader object from source code
+    DecodedTextureLoads++;
+    AtlasRegions[handle] = Atlas.Add(width, height, data);
+    stbi_image_free(data);
+    return AtlasRegions[handle];
+}
+
+const AtlasRegion &ResourceManager::GetAtlasRegion(const std::string &name)
+{
+    return AtlasRegions[name];
+}
+
+ResourceHandle<Texture2D> ResourceManager::LoadTextureAsync(const char *file, bool alpha, std::string name)
+{
+    ResourceHandle<Texture2D> handle = Textures.Insert(name);
+    if (handle.Valid())
+        loadAsync(file, false, handle.Index, alpha);
+    return handle;
+}
+
+ResourceHandle<AtlasRegion> ResourceManager::LoadAtlasTextureAsync(const char *file, std::string name)
+{
+    ResourceHandle<AtlasRegion> handle = AtlasRegions.Insert(name);
+    if (handle.Valid())
+        loadAsync(file, true, handle.Index, true);
+    return handle;
+}
+
+void ResourceManager::FinalizeLoads(double budgetSeconds)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (pendingLoads > 0)
+    {
+        std::unique_lock<std::mutex> lock(decodedMutex);
+        if (decoded.empty())
+            return;
+        DecodedImage image = std::move(decoded.front());
+        decoded.pop_front();
+        lock.unlock();
+        finalizeLoad(image);
+        if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= budgetSeconds)
+            return;
+    }
+}
+
+void ResourceManager::FinishLoads()
+{
+    if (loaders != nullptr)
+        loaders->Wait();
+    FinalizeLoads(std::numeric_limits<double>::infinity());
+    UploadContext::Finish();
+}
+
+void ResourceManager::Clear()
+{
+    // let the loader threads finish and drop whatever they decoded; the resources it was meant for are deleted below
+    delete loaders;
+    loaders = nullptr;
+    decoded.clear();
+    shaderCode.clear();
+    UploadContext::Finish();
+    pendingLoads = 0;
+    // stop watching and drop rebuilds still in flight
+    delete shaderWatcher;
+    shaderWatcher = nullptr;
+    shaderReloads.clear();
+    shaderSources.clear();
+    // (properly) delete all shaders and textures; they release their GL objects when destroyed
+    Shaders.Clear();
+    missingShader = Shader();
+    Textures.Clear();
+    TextureArrays.Clear();
+    // delete the atlas pages
+    Atlas.Clear();
+    AtlasRegions.Clear();
+    // every program and texture is owned by a resource above, so anything still alive leaked
+    GLObjectCounts live = GLState::LiveObjects();
+    if (live.Programs != 0 || live.Textures != 0)
+        std::cout << "ERROR::RESOURCE_MANAGER: Leaked " << live.Programs << " programs and " << live.Textures << " textures" << std::endl;
+    else
+        std::cout << "Resources released, no programs or textures leaked (" << live.Buffers << " buffers and " << live.VertexArrays << " vertex arrays still owned elsewhere)" << std::endl;
+}
+
+Shader ResourceManager::loadShaderFromFile(ShaderSource &source, std::uint64_t *pendingKey)
+{
+    ShaderCode code = readShaderCode(source);
+    source.Dependencies = code.Dependencies;
+    return buildShader(code, pendingKey);
+}
+
+ResourceManager::ShaderCode ResourceManager::readShaderCode(const ShaderSource &source)
+{
+    // retrieve the vertex/fragment source code from filePath, resolving includes and injecting the permutation's defines
+    ShaderCode code;
+    code.Revision = source.Revision;
+    code.Vertex = preprocessShader(source.Files[0], source.Defines, code.Dependencies);
+    code.Fragment = preprocessShader(source.Files[1], source.Defines, code.Dependencies);
+    // if geometry shader path is present, also load a geometry shader
+    code.HasGeometry = source.Files.size() > 2;
+    if (code.HasGeometry)
+        code.Geometry = preprocessShader(source.Files[2], source.Defines, code.Dependencies);
+    return code;
+}
+
+Shader ResourceManager::buildShader(const ShaderCode &code, std::uint64_t *pendingKey)
+{
+    const char *vShaderCode = code.Vertex.c_str();
+    const char *fShaderCode = code.Fragment.c_str();
+    const char *gShaderCode = code.HasGeometry ? code.Geometry.c_str() : nullptr;
+    // create shader object, from the program binary cache if possible, otherwise from source code
+    auto start = std::chrono::steady_clock::now();
     Shader shader;
-    shader.Compile(vShaderCode, fShaderCode, gShaderFile != nullptr ? gShaderCode : nullptr);
+    std::uint64_t key = ProgramBinaryCache::Key(vShaderCode, fShaderCode, gShaderCode);
+    if (!ProgramBinaryCache::Load(key, shader))
+    {
+        if (pendingKey != nullptr)
+        {
+            // in a batch the status checks and the cache store wait for EndShaderBatch
+            shader.Submit(vShaderCode, fShaderCode, gShaderCode);
+            *pendingKey = key;
+        }
+        else
+        {
+            shader.Compile(vShaderCode, fShaderCode, gShaderCode);
+            ProgramBinaryCache::Store(key, shader);
+        }
+    }
+    ShaderLoadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     return shader;
 }
 
+std::string ResourceManager::preprocessShader(const std::string &file, const std::vector<std::string> &defines, std::vector<std::string> &dependencies)
+{
+    std::string code = expandIncludes(file, dependencies, 0);
+    // the defines have to follow #version, which must stay the first statement
+    std::string defineBlock;
+    for (const std::string &define : defines)
+    {
+        std::string::size_type equals = define.find('=');
+        defineBlock += "#define " + (equals == std::string::npos ? define : define.substr(0, equals) + " " + define.substr(equals + 1)) + "\n";
+    }
+    std::string::size_type version = code.find("#version");
+    std::string::size_type insert = version == std::string::npos ? 0 : code.find('\n', version);
+    if (insert == std::string::npos)
+        return code + "\n" + defineBlock;
+    if (version != std::string::npos)
+    {
+        ++insert;
+        int sourceNumber = static_cast<int>(std::find(dependencies.begin(), dependencies.end(), file) - dependencies.begin());
+        defineBlock += "#line " + std::to_string(std::count(code.begin(), code.begin() + insert, '\n') + 1) + " " + std::to_string(sourceNumber) + "\n";
+    }
+    return code.insert(insert, defineBlock);
+}
+
+std::string ResourceManager::expandIncludes(const std::string &file, std::vector<std::string> &dependencies, int depth)
+{
+    if (depth > 16)
+    {
+        std::cout << "ERROR::SHADER: Includes nested too deep (cycle?) at " << file << std::endl;
+        return "";
+    }
+    std::ifstream stream(file);
+    if (!stream)
+    {
+        std::cout << "ERROR::SHADER: Failed to read shader file " << file << std::endl;
+        return "";
+    }
+    // the index of the file in dependencies is the source string number compile errors report for it
+    int sourceNumber = static_cast<int>(std::find(dependencies.begin(), dependencies.end(), file) - dependencies.begin());
+    if (sourceNumber == static_cast<int>(dependencies.size()))
+        dependencies.push_back(file);
+    std::string::size_type slash = file.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "" : file.substr(0, slash + 1);
+    std::stringstream code;
+    if (depth > 0)
+        code << "#line 1 " << sourceNumber << "\n";
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(stream, line))
+    {
+        ++lineNumber;
+        // #include "path" is resolved relative to the including file
+        std::string::size_type start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+        {
+            code << line << "\n";
+            continue;
+        }
+        std::string::size_type open = line.find('"', start + 8);
+        std::string::size_type close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos)
+        {
+            std::cout << "ERROR::SHADER: Malformed #include in " << file << ":" << lineNumber << std::endl;
+            continue;
+        }
+        // normalized so a file included from different directories is one dependency
+        std::string included = std::filesystem::path(directory + line.substr(open + 1, close - open - 1)).lexically_normal().generic_string();
+        code << expandIncludes(included, dependencies, depth + 1);
+        code << "#line " << lineNumber + 1 << " " << sourceNumber << "\n";
+    }
+    return code.str();
+}
+
 Texture2D ResourceManager::loadTextureFromFile(const char *file, bool alpha)
 {
     // create texture object
@@ -104,6 +524,17 @@ Texture2D ResourceManager::loadTextureFromFile(const char *file, bool alpha)
         texture.Internal_Format = GL_RGBA;
         texture.Image_Format = GL_RGBA;
     }
+    // a cooked file needs no decoding: the upload reads straight from the mapping
+    CookedTexture cooked(CookedTexture::CookedPath(file));
+    if (cooked.Valid())
+    {
+        std::vector<const unsigned char*> levels;
+        useCooked(cooked, texture, levels);
+        texture.Generate(cooked.Header().Width, cooked.Header().Height, static_cast<unsigned int>(levels.size()), levels.data());
+        CookedTextureLoads++;
+        return texture;
+    }
+    DecodedTextureLoads++;
     // load image
     int width, height, nrChannels;
     unsigned char* data = stbi_load(file, &width, &height, &nrChannels, 0);
@@ -112,4 +543,90 @@ Texture2D ResourceManager::loadTextureFromFile(const char *file, bool alpha)
     // and finally free image data
     stbi_image_free(data);
     return texture;
+}
+
+void ResourceManager::loadAsync(const char *file, bool atlas, std::uint32_t index, bool alpha)
+{
+    if (loaders == nullptr)
+        loaders = new ThreadPool();
+    ++pendingLoads;
+    std::string path(file);
+    loaders->Submit([path, atlas, index, alpha]()
+    {
+        std::shared_ptr<CookedTexture> cooked = std::make_shared<CookedTexture>(CookedTexture::CookedPath(path));
+        if (cooked->Valid() && (!atlas || cooked->Header().Channels == 4))
+        {
+            // fault the mapping in here rather than during the upload on the GL thread
+            cooked->Prefetch();
+            std::lock_guard<std::mutex> lock(decodedMutex);
+            decoded.push_back({ atlas, index, alpha, static_cast<int>(cooked->Header().Width), static_cast<int>(cooked->Header().Height), path, { nullptr, stbi_image_free }, cooked });
+            return;
+        }
+        // atlas pages are always RGBA; plain textures keep the file's channels like loadTextureFromFile
+        int width = 0, height = 0, nrChannels;
+        unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrChannels, atlas ? 4 : 0);
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        decoded.push_back({ atlas, index, alpha, width, height, path, { data, stbi_image_free }, nullptr });
+    });
+}
+
+void ResourceManager::finalizeLoad(DecodedImage &image)
+{
+    if (image.Cooked)
+        CookedTextureLoads++;
+    else if (image.Pixels == nullptr)
+        std::cout << "ERROR::TEXTURE: Failed to load " << image.File << std::endl;
+    else
+        DecodedTextureLoads++;
+    // atlas pages are shared and bound through GLState, so packing stays on the render thread
+    if (image.Atlas)
+    {
+        const unsigned char *pixels = image.Cooked ? image.Cooked->Level(0) : image.Pixels.get();
+        if (pixels != nullptr)
+        {
+            AtlasRegion &region = AtlasRegions[ResourceHandle<AtlasRegion>(image.Index)] = Atlas.Add(image.Width, image.Height, pixels);
+            region.Premultiplied = image.Cooked && (image.Cooked->Header().Flags & BTEX_PREMULTIPLIED) != 0;
+        }
+        --pendingLoads;
+        return;
+    }
+    std::shared_ptr<Texture2D> texture = std::make_shared<Texture2D>();
+    if (image.Alpha)
+    {
+        texture->Internal_Format = GL_RGBA;
+        texture->Image_Format = GL_RGBA;
+    }
+    std::vector<const unsigned char*> levels(1, image.Pixels.get());
+    if (image.Cooked)
+        useCooked(*image.Cooked, *texture, levels);
+    ResourceHandle<Texture2D> handle(image.Index);
+    if (!UploadContext::Running())
+    {
+        texture->Generate(image.Width, image.Height, static_cast<unsigned int>(levels.size()), levels.data());
+        Textures[handle] = std::move(*texture);
+        --pendingLoads;
+        return;
+    }
+    // the name is created here so GLState counts it; the upload thread only fills in the image
+    texture->ID = GLState::GenTexture();
+    std::shared_ptr<DecodedImage> pixels = std::make_shared<DecodedImage>(std::move(image));
+    UploadContext::Submit([texture, pixels, levels]()
+    {
+        texture->Upload(pixels->Width, pixels->Height, static_cast<unsigned int>(levels.size()), levels.data());
+    }, [texture, handle]()
+    {
+        Textures[handle] = std::move(*texture);
+        --pendingLoads;
+    });
+}
+
+void ResourceManager::useCooked(const CookedTexture &cooked, Texture2D &texture, std::vector<const unsigned char*> &levels)
+{
+    texture.Internal_Format = texture.Image_Format = cooked.Header().Channels == 4 ? GL_RGBA : GL_RGB;
+    texture.Premultiplied = (cooked.Header().Flags & BTEX_PREMULTIPLIED) != 0;
+    levels.clear();
+    for (unsigned int level = 0; level < cooked.Header().Levels; ++level)
+        levels.push_back(cooked.Level(level));
+    if (levels.size() > 1 && texture.Filter_Min == GL_LINEAR)
+        texture.Filter_Min = GL_LINEAR_MIPMAP_LINEAR;
 }
\ No newline at end of file
@@ -9,12 +9,22 @@
 #ifndef RESOURCE_MANAGER_H
 #define RESOURCE_MANAGER_H
 
+#include <cstdint>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 
+#include "cooked_texture.h"
+#include "file_watcher.h"
+#include "resource_registry.h"
 #include "texture.h"
+#include "texture_atlas.h"
+#include "thread_pool.h"
 #include "shader.h"
 
 
@@ -22,30 +32,163 @@
 // functions to load Textures and Shaders. Each loaded texture
 // and/or shader is also stored for future reference by string
 // handles. All functions and resources are static and no 
-// public constructor is defined.
+// public constructor is defined. The stored resources own their GL
+// objects; the Get functions hand out references to them, pass views
+// (Texture2DView) or references on instead of copies. Lookups by
+// string name are meant for loading code; per-frame code resolves a
+// handle once (Find*) or uses a compile-time hashed name ("face"_id).
+// The *Async loads return a handle right away and decode the file on a
+// loader thread; FinalizeLoads then uploads the decoded images from the
+// GL thread, a few per frame, so loading never stalls a frame for long.
+// While the UploadContext runs, texture uploads move to its thread too
+// and a texture appears once its upload fence signaled.
 class ResourceManager
 {
 public:
     // resource storage
-    static std::map<std::string, Shader>    Shaders;
-    static std::map<std::string, Texture2D> Textures;
+    static ResourceRegistry<Shader>         Shaders;
+    static ResourceRegistry<Texture2D>      Textures;
+    static ResourceRegistry<Texture2DArray> TextureArrays;
+    static ResourceRegistry<AtlasRegion>    AtlasRegions;
+    // shared atlas pages that atlas textures are packed into
+    static TextureAtlas                      Atlas;
+    // time spent creating shader programs (cache lookups, compiling and linking) since startup
+    static double                            ShaderLoadSeconds;
+    // textures (and atlas images) loaded from a cooked .btex file next to the requested image, and ones decoded from the image itself
+    static unsigned int                      CookedTextureLoads, DecodedTextureLoads;
     // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
-    static Shader    LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name);
+    static Shader   &LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name);
+    // same, with a list of "KEY" or "KEY=VALUE" defines injected after #version; sources may #include "path" relative to themselves
+    static Shader   &LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, const std::vector<std::string> &defines, std::string name);
+    // registers shader sources whose permutations are built on demand by GetShaderVariant
+    static void      RegisterShaderVariants(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name);
+    // retrieves the permutation of a registered shader for a set of defines, compiling it on first use; it is stored as e.g. "sprite+ATLAS+TINT"
+    static Shader   &GetShaderVariant(const std::string &name, std::vector<std::string> defines);
+    // starts a batch: shaders loaded until EndShaderBatch are only submitted, so the driver can compile them in parallel
+    static void      BeginShaderBatch();
+    // waits for all shaders submitted since BeginShaderBatch and checks their compile/link status
+    static void      EndShaderBatch();
+    // starts watching the source files of all loaded shaders so UpdateShaders can rebuild them when they change
+    static void      WatchShaders();
+    // call once per frame: reads changed shaders on a loader thread, submits them for recompiling and swaps in the ones that finished (a failed build keeps the old program)
+    static void      UpdateShaders();
     // retrieves a stored sader
-    static Shader    GetShader(std::string name);
-    // loads (and generates) a texture from file
-    static Texture2D LoadTexture(const char *file, bool alpha, std::string name);
+    static Shader   &GetShader(const std::string &name);
+    static Shader   &GetShader(ResourceID id) { ResourceHandle<Shader> handle = Shaders.Find(id); return handle.Valid() ? Shaders[handle] : missingShader; }
+    static Shader   &GetShader(ResourceHandle<Shader> handle) { return Shaders[handle]; }
+    static ResourceHandle<Shader> FindShader(ResourceID id) { return Shaders.Find(id); }
+    // loads (and generates) a texture from file; if a cooked file.btex exists (see CookedTexture) it is mapped and uploaded instead, mip levels included
+    static const Texture2D &LoadTexture(const char *file, bool alpha, std::string name);
     // retrieves a stored texture
-    static Texture2D GetTexture(std::string name);
-    // properly de-allocates all loaded resources
+    static const Texture2D &GetTexture(const std::string &name);
+    static const Texture2D &GetTexture(ResourceID id) { return Textures[id]; }
+    static const Texture2D &GetTexture(ResourceHandle<Texture2D> handle) { return Textures[handle]; }
+    static ResourceHandle<Texture2D> FindTexture(ResourceID id) { return Textures.Find(id); }
+    // loads a list of equally sized images into the layers of one array texture
+    static const Texture2DArray &LoadTextureArray(const std::vector<std::string> &files, bool alpha, std::string name);
+    // retrieves a stored array texture
+    static const Texture2DArray &GetTextureArray(const std::string &name);
+    static const Texture2DArray &GetTextureArray(ResourceID id) { return TextureArrays[id]; }
+    static const Texture2DArray &GetTextureArray(ResourceHandle<Texture2DArray> handle) { return TextureArrays[handle]; }
+    static ResourceHandle<Texture2DArray> FindTextureArray(ResourceID id) { return TextureArrays.Find(id); }
+    // loads a texture from file and packs it into the shared atlas instead of giving it its own texture object
+    static const AtlasRegion &LoadAtlasTexture(const char *file, std::string name);
+    // retrieves a stored atlas region
+    static const AtlasRegion &GetAtlasRegion(const std::string &name);
+    static const AtlasRegion &GetAtlasRegion(ResourceID id) { return AtlasRegions[id]; }
+    static const AtlasRegion &GetAtlasRegion(ResourceHandle<AtlasRegion> handle) { return AtlasRegions[handle]; }
+    static ResourceHandle<AtlasRegion> FindAtlasRegion(ResourceID id) { return AtlasRegions.Find(id); }
+    // like LoadTexture, but the file is decoded on a loader thread; the texture stays empty (ID 0) until FinalizeLoads uploads it
+    static ResourceHandle<Texture2D>   LoadTextureAsync(const char *file, bool alpha, std::string name);
+    // like LoadAtlasTexture, but the file is decoded on a loader thread; the region stays empty (Texture 0) until FinalizeLoads packs it; both return an invalid handle if name collides with a registered name
+    static ResourceHandle<AtlasRegion> LoadAtlasTextureAsync(const char *file, std::string name);
+    // call once per frame on the GL thread: uploads decoded images until budgetSeconds are spent (at least one, if any is ready)
+    static void      FinalizeLoads(double budgetSeconds);
+    // blocks until every async load has been decoded and uploaded
+    static void      FinishLoads();
+    // async loads that are not visible yet (decoding, waiting for FinalizeLoads or on the upload thread)
+    static unsigned int PendingLoads() { return pendingLoads; }
+    // properly de-allocates all loaded resources and reports GL programs and textures that are still alive afterwards
     static void      Clear();
 private:
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
     ResourceManager() { }
-    // loads and generates a shader from file
-    static Shader    loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr);
+    // true between BeginShaderBatch and EndShaderBatch
+    static bool      shaderBatch;
+    // true if the driver compiles the current batch on background threads
+    static bool      parallelShaders;
+    // a changed shader being rebuilt; Program is swapped in once it finished compiling
+    struct ShaderReload
+    {
+        std::string   Name;
+        std::uint64_t Key;       // program cache key, 0 if the program came from the cache
+        Shader        Program;
+        bool          Submitted; // submitted during the current UpdateShaders, the driver had no time to compile it yet
+    };
+    // what a loaded shader was built from
+    struct ShaderSource
+    {
+        std::vector<std::string> Files;          // vertex, fragment and optional geometry shader
+        std::vector<std::string> Defines;
+        std::vector<std::string> Dependencies;   // Files plus everything they include
+        unsigned int             Revision = 0;   // counts the changes seen by UpdateShaders, older reads are dropped
+    };
+    // the preprocessed sources of a shader, ready to be compiled
+    struct ShaderCode
+    {
+        std::string              Name;
+        unsigned int             Revision;
+        std::string              Vertex, Fragment, Geometry;
+        bool                     HasGeometry;
+        std::vector<std::string> Dependencies;
+    };
+    static std::map<std::string, ShaderSource> shaderSources;
+    // source files of the shaders registered with RegisterShaderVariants
+    static std::map<std::string, std::vector<std::string>> shaderVariants;
+    // watcher over all shaderFiles, nullptr until WatchShaders
+    static FileWatcher *shaderWatcher;
+    static std::vector<ShaderReload> shaderReloads;
+    // changed shaders read by the loader threads, waiting to be submitted by UpdateShaders
+    static std::mutex              shaderCodeMutex;
+    static std::vector<ShaderCode> shaderCode;   // guarded by shaderCodeMutex
+    // shaders submitted in the current batch and the cache keys to store them under
+    static std::vector<std::pair<std::uint64_t, ResourceHandle<Shader>>> pendingShaders;
+    // handed out for unknown shader names and names that were refused; it never gets a program, loads don't store into it
+    static Shader missingShader;
+    // loads and generates a shader from file, recording its dependencies; pendingKey receives the cache key if the shader was only submitted
+    static Shader    loadShaderFromFile(ShaderSource &source, std::uint64_t *pendingKey = nullptr);
+    // reads and preprocesses the sources of a shader; touches no GL or shared state, so it runs on loader threads too
+    static ShaderCode readShaderCode(const ShaderSource &source);
+    // generates a shader from preprocessed sources, from the program binary cache if possible
+    static Shader    buildShader(const ShaderCode &code, std::uint64_t *pendingKey);
+    // reads a shader source with its includes resolved and defines injected after #version
+    static std::string preprocessShader(const std::string &file, const std::vector<std::string> &defines, std::vector<std::string> &dependencies);
+    // reads file, replacing each #include "path" line with the (recursively expanded) file it names
+    static std::string expandIncludes(const std::string &file, std::vector<std::string> &dependencies, int depth);
     // loads a single texture from file
     static Texture2D loadTextureFromFile(const char *file, bool alpha);
+    // an image decoded by a loader thread, waiting for its upload on the GL thread
+    struct DecodedImage
+    {
+        bool          Atlas;       // fills AtlasRegions instead of Textures
+        std::uint32_t Index;       // handle of the resource it fills
+        bool          Alpha;
+        int           Width, Height;
+        std::string   File;
+        std::unique_ptr<unsigned char, void(*)(void*)> Pixels;  // stbi_load result, nullptr if decoding failed or the file was cooked
+        std::shared_ptr<CookedTexture> Cooked;                  // the mapped .btex file if there was one
+    };
+    // loader threads, created by the first async load
+    static ThreadPool *loaders;
+    static std::mutex  decodedMutex;
+    static std::deque<DecodedImage> decoded;     // guarded by decodedMutex
+    static unsigned int pendingLoads;
+    // queues file for decoding; the result fills the resource at index once finalized
+    static void      loadAsync(const char *file, bool atlas, std::uint32_t index, bool alpha);
+    // creates the GL side of a decoded image
+    static void      finalizeLoad(DecodedImage &image);
+    // takes the formats of a cooked texture and collects its mip levels; a full chain also turns on trilinear filtering
+    static void      useCooked(const CookedTexture &cooked, Texture2D &texture, std::vector<const unsigned char*> &levels);
 };
 
 #endif
\ No newline at end of file
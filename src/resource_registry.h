@@ -0,0 +1,135 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef RESOURCE_REGISTRY_H
+#define RESOURCE_REGISTRY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hash.h"
+
+
+// A resource name hashed with FNV-1a. Written as a literal ("face"_id)
+// the hash is computed by the compiler, so looking a resource up by it
+// never touches a string.
+struct ResourceID
+{
+    std::uint32_t Hash;
+    explicit constexpr ResourceID(const char *name) : Hash(Fnv1a(name)) { }
+};
+
+constexpr ResourceID operator"" _id(const char *name, std::size_t)
+{
+    return ResourceID(name);
+}
+
+// Stable index of a resource inside its ResourceRegistry. Handles stay
+// valid until the registry is cleared; a default constructed handle is
+// invalid.
+template <typename T>
+struct ResourceHandle
+{
+    static const std::uint32_t INVALID = 0xFFFFFFFFu;
+    std::uint32_t Index;
+    ResourceHandle() : Index(INVALID) { }
+    explicit ResourceHandle(std::uint32_t index) : Index(index) { }
+    bool Valid() const { return this->Index != INVALID; }
+};
+
+// Named resources stored back to back, addressed by handle (an index)
+// or by hashed name (a binary search over integers). String names are
+// only hashed when a resource is added or looked up by std::string,
+// which is meant for loading code; only Insert adds resources. Storage
+// is a std::deque so it can be indexed directly while growing never
+// moves existing resources: references handed out earlier (e.g. the
+// shaders a renderer keeps) stay valid.
+template <typename T>
+class ResourceRegistry
+{
+public:
+    typedef ResourceHandle<T> Handle;
+    // returns the handle of name, adding a default constructed resource first if there is none;
+    // a name whose hash is already taken by another name is refused with an invalid handle
+    Handle Insert(const std::string &name)
+    {
+        ResourceID id(name.c_str());
+        auto entry = std::lower_bound(this->lookup.begin(), this->lookup.end(), std::make_pair(id.Hash, 0u));
+        if (entry != this->lookup.end() && entry->first == id.Hash)
+        {
+            if (this->names[entry->second] != name)
+            {
+                std::cout << "ERROR::RESOURCE_REGISTRY: " << name << " and " << this->names[entry->second] << " share the name hash " << id.Hash << ", " << name << " is not added" << std::endl;
+                return Handle();
+            }
+            return Handle(entry->second);
+        }
+        std::uint32_t index = static_cast<std::uint32_t>(this->resources.size());
+        this->resources.emplace_back();
+        this->names.push_back(name);
+        this->lookup.insert(entry, std::make_pair(id.Hash, index));
+        return Handle(index);
+    }
+    // returns the handle of a registered name, or an invalid handle
+    Handle Find(ResourceID id) const
+    {
+        auto entry = std::lower_bound(this->lookup.begin(), this->lookup.end(), std::make_pair(id.Hash, 0u));
+        if (entry == this->lookup.end() || entry->first != id.Hash)
+            return Handle();
+        return Handle(entry->second);
+    }
+    // same, but a different name that merely shares the hash isn't a match
+    Handle Find(const std::string &name) const
+    {
+        Handle handle = this->Find(ResourceID(name.c_str()));
+        if (handle.Valid() && this->names[handle.Index] != name)
+            return Handle();
+        return handle;
+    }
+    // resource access; handles must be valid
+    T &operator[](Handle handle) { return this->resources[handle.Index]; }
+    const T &operator[](Handle handle) const { return this->resources[handle.Index]; }
+    // lookups by name never add a resource, unknown names yield Fallback
+    const T &operator[](ResourceID id) const
+    {
+        Handle handle = this->Find(id);
+        return handle.Valid() ? this->resources[handle.Index] : Fallback;
+    }
+    const T &operator[](const std::string &name) const
+    {
+        Handle handle = this->Find(name);
+        return handle.Valid() ? this->resources[handle.Index] : Fallback;
+    }
+    // default constructed resource handed out for unknown names; it owns no GL object and can't be written to
+    static const T Fallback;
+    // the name a resource was registered under
+    const std::string &Name(Handle handle) const { return this->names[handle.Index]; }
+    std::size_t Size() const { return this->resources.size(); }
+    // destroys all resources, invalidating every handle
+    void Clear()
+    {
+        this->resources.clear();
+        this->names.clear();
+        this->lookup.clear();
+    }
+private:
+    std::deque<T>            resources;
+    std::vector<std::string> names;     // parallel to resources
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> lookup;  // (name hash, index), sorted by hash
+};
+
+template <typename T>
+const T ResourceRegistry<T>::Fallback = T();
+
+#endif
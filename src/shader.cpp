@@ -7,104 +7,452 @@
 ** option) any later version.
 ******************************************************************/
 #include "shader.h"
+#include "gl_state.h"
 
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <string>
+
+// GL_KHR_parallel_shader_compile isn't part of the generated glad loader
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+bool Shader::parallelCompile = false;
+std::vector<std::pair<std::string, unsigned int>> Shader::blockBindings;
+
+Shader::~Shader()
+{
+    this->release();
+}
+
+Shader::Shader(Shader &&other) noexcept
+    : ID(other.ID), state(std::move(other.state))
+{
+    other.ID = 0;
+}
+
+Shader &Shader::operator=(Shader &&other) noexcept
+{
+    if (this != &other)
+    {
+        this->release();
+        this->ID = other.ID;
+        this->state = std::move(other.state);
+        other.ID = 0;
+    }
+    return *this;
+}
+
+void Shader::release()
+{
+    if (this->state)
+        for (unsigned int stage : this->state->Stages)
+            if (stage != 0)
+                glDeleteShader(stage);
+    GLState::DeleteProgram(this->ID);
+    this->ID = 0;
+    this->state.reset();
+}
 
 Shader &Shader::Use()
 {
-    glUseProgram(this->ID);
+    // first use of a submitted program is where its deferred status check happens
+    if (this->state && this->state->Pending)
+        this->finishLink();
+    GLState::UseProgram(this->ID);
     return *this;
 }
 
 void Shader::Compile(const char* vertexSource, const char* fragmentSource, const char* geometrySource)
 {
-    unsigned int sVertex, sFragment, gShader;
+    this->Submit(vertexSource, fragmentSource, geometrySource);
+    this->Finish();
+}
+
+void Shader::Submit(const char* vertexSource, const char* fragmentSource, const char* geometrySource)
+{
+    this->release();
+    this->state.reset(new ProgramState());
+    this->state->Pending = true;
+    unsigned int sVertex, sFragment, gShader = 0;
     // vertex Shader
     sVertex = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(sVertex, 1, &vertexSource, NULL);
     glCompileShader(sVertex);
-    checkCompileErrors(sVertex, "VERTEX");
     // fragment Shader
     sFragment = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(sFragment, 1, &fragmentSource, NULL);
     glCompileShader(sFragment);
-    checkCompileErrors(sFragment, "FRAGMENT");
     // if geometry shader source code is given, also compile geometry shader
     if (geometrySource != nullptr)
     {
         gShader = glCreateShader(GL_GEOMETRY_SHADER);
         glShaderSource(gShader, 1, &geometrySource, NULL);
         glCompileShader(gShader);
-        checkCompileErrors(gShader, "GEOMETRY");
     }
     // shader program
-    this->ID = glCreateProgram();
+    this->ID = GLState::CreateProgram();
     glAttachShader(this->ID, sVertex);
     glAttachShader(this->ID, sFragment);
     if (geometrySource != nullptr)
         glAttachShader(this->ID, gShader);
+    // ask the driver to keep the binary around for the program binary cache
+    if (GLAD_GL_VERSION_4_1)
+        glProgramParameteri(this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(this->ID);
-    checkCompileErrors(this->ID, "PROGRAM");
-    // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(sVertex);
-    glDeleteShader(sFragment);
-    if (geometrySource != nullptr)
-        glDeleteShader(gShader);
+    // querying any status here would wait for the compiler, so keep the stages for Finish
+    this->state->Stages[0] = sVertex;
+    this->state->Stages[1] = sFragment;
+    this->state->Stages[2] = gShader;
 }
 
-void Shader::SetFloat(const char *name, float value, bool useShader)
+bool Shader::IsReady() const
+{
+    if (!this->state || !this->state->Pending || !parallelCompile)
+        return true;
+    GLint done = GL_FALSE;
+    glGetProgramiv(this->ID, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+bool Shader::Finish()
+{
+    return this->state && this->finishLink();
+}
+
+bool Shader::Replace(Shader &fresh)
+{
+    if (!this->state || !fresh.state || !fresh.finishLink())
+        return false;
+    unsigned int old = this->ID;
+    this->ID = fresh.ID;
+    this->state->Linked = true;
+    this->buildUniformTable();
+    // the new program starts out with default values, give it the ones the old one held
+    GLState::UseProgram(this->ID);
+    for (const ProgramState::UniformSlot &slot : this->state->Uniforms)
+        if (slot.Known && slot.Location >= 0)
+            upload(slot);
+    GLState::DeleteProgram(old);
+    fresh.state.reset();
+    fresh.ID = 0;
+    return true;
+}
+
+void Shader::BindUniformBlock(const char *block, unsigned int binding)
+{
+    for (auto &blockBinding : blockBindings)
+        if (blockBinding.first == block)
+        {
+            blockBinding.second = binding;
+            return;
+        }
+    blockBindings.push_back(std::make_pair(std::string(block), binding));
+}
+
+bool Shader::EnableParallelCompile()
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    const char *function = nullptr;
+    for (GLint i = 0; i < count && function == nullptr; ++i)
+    {
+        const char *extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0)
+            function = "glMaxShaderCompilerThreadsKHR";
+        else if (std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+            function = "glMaxShaderCompilerThreadsARB";
+    }
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = function != nullptr ? reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress(function)) : nullptr;
+    if (maxShaderCompilerThreads == nullptr)
+        return parallelCompile = false;
+    // let the implementation pick the number of threads
+    maxShaderCompilerThreads(0xFFFFFFFFu);
+    return parallelCompile = true;
+}
+
+bool Shader::LoadBinary(GLenum format, const void *binary, GLsizei length)
+{
+    if (!GLAD_GL_VERSION_4_1)
+        return false;
+    unsigned int program = GLState::CreateProgram();
+    glProgramBinary(program, format, binary, length);
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        GLState::DeleteProgram(program);
+        return false;
+    }
+    this->release();
+    this->ID = program;
+    this->state.reset(new ProgramState());
+    this->state->Linked = true;
+    this->buildUniformTable();
+    return true;
+}
+
+bool Shader::GetBinary(GLenum &format, std::vector<char> &binary) const
+{
+    if (!GLAD_GL_VERSION_4_1 || !this->state || !this->finishLink())
+        return false;
+    GLint length = 0;
+    glGetProgramiv(this->ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+    binary.resize(length);
+    glGetProgramBinary(this->ID, length, &length, &format, binary.data());
+    binary.resize(length);
+    return length > 0;
+}
+
+UniformHandle Shader::Uniform(UniformID id) const
+{
+    if (!this->state)
+        return { -1 };
+    // the uniform table is only known once the program linked
+    if (this->state->Pending)
+        this->finishLink();
+    const std::vector<std::pair<std::uint32_t, int>> &lookup = this->state->Lookup;
+    auto entry = std::lower_bound(lookup.begin(), lookup.end(), std::make_pair(id.Hash, -1));
+    if (entry == lookup.end() || entry->first != id.Hash)
+        return { -1 };
+    return { entry->second };
+}
+
+UniformHandle Shader::Uniform(const char *name) const
+{
+    return this->Uniform(UniformID(name));
+}
+
+void Shader::SetFloat(UniformHandle handle, float value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform1f(glGetUniformLocation(this->ID, name), value);
+    if (ProgramState::UniformSlot *entry = this->changed(handle, &value, 1))
+        glUniform1f(entry->Location, value);
 }
-void Shader::SetInteger(const char *name, int value, bool useShader)
+void Shader::SetInteger(UniformHandle handle, int value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform1i(glGetUniformLocation(this->ID, name), value);
+    if (ProgramState::UniformSlot *entry = this->changed(handle, &value, 1))
+        glUniform1i(entry->Location, value);
 }
-void Shader::SetVector2f(const char *name, float x, float y, bool useShader)
+void Shader::SetVector2f(UniformHandle handle, float x, float y, bool useShader)
+{
+    this->SetVector2f(handle, glm::vec2(x, y), useShader);
+}
+void Shader::SetVector2f(UniformHandle handle, const glm::vec2 &value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+    if (ProgramState::UniformSlot *entry = this->changed(handle, glm::value_ptr(value), 2))
+        glUniform2f(entry->Location, value.x, value.y);
 }
-void Shader::SetVector2f(const char *name, const glm::vec2 &value, bool useShader)
+void Shader::SetVector3f(UniformHandle handle, float x, float y, float z, bool useShader)
+{
+    this->SetVector3f(handle, glm::vec3(x, y, z), useShader);
+}
+void Shader::SetVector3f(UniformHandle handle, const glm::vec3 &value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+    if (ProgramState::UniformSlot *entry = this->changed(handle, glm::value_ptr(value), 3))
+        glUniform3f(entry->Location, value.x, value.y, value.z);
 }
-void Shader::SetVector3f(const char *name, float x, float y, float z, bool useShader)
+void Shader::SetVector4f(UniformHandle handle, float x, float y, float z, float w, bool useShader)
+{
+    this->SetVector4f(handle, glm::vec4(x, y, z, w), useShader);
+}
+void Shader::SetVector4f(UniformHandle handle, const glm::vec4 &value, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    if (ProgramState::UniformSlot *entry = this->changed(handle, glm::value_ptr(value), 4))
+        glUniform4f(entry->Location, value.x, value.y, value.z, value.w);
 }
-void Shader::SetVector3f(const char *name, const glm::vec3 &value, bool useShader)
+void Shader::SetMatrix4(UniformHandle handle, const glm::mat4 &matrix, bool useShader)
 {
     if (useShader)
         this->Use();
-    glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    if (ProgramState::UniformSlot *entry = this->changed(handle, glm::value_ptr(matrix), 16))
+        glUniformMatrix4fv(entry->Location, 1, false, glm::value_ptr(matrix));
+}
+
+void Shader::SetFloat(const char *name, float value, bool useShader)
+{
+    this->SetFloat(this->Uniform(name), value, useShader);
+}
+void Shader::SetInteger(const char *name, int value, bool useShader)
+{
+    this->SetInteger(this->Uniform(name), value, useShader);
+}
+void Shader::SetVector2f(const char *name, float x, float y, bool useShader)
+{
+    this->SetVector2f(this->Uniform(name), x, y, useShader);
+}
+void Shader::SetVector2f(const char *name, const glm::vec2 &value, bool useShader)
+{
+    this->SetVector2f(this->Uniform(name), value, useShader);
+}
+void Shader::SetVector3f(const char *name, float x, float y, float z, bool useShader)
+{
+    this->SetVector3f(this->Uniform(name), x, y, z, useShader);
+}
+void Shader::SetVector3f(const char *name, const glm::vec3 &value, bool useShader)
+{
+    this->SetVector3f(this->Uniform(name), value, useShader);
 }
 void Shader::SetVector4f(const char *name, float x, float y, float z, float w, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+    this->SetVector4f(this->Uniform(name), x, y, z, w, useShader);
 }
 void Shader::SetVector4f(const char *name, const glm::vec4 &value, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    this->SetVector4f(this->Uniform(name), value, useShader);
 }
 void Shader::SetMatrix4(const char *name, const glm::mat4 &matrix, bool useShader)
 {
-    if (useShader)
-        this->Use();
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, false, glm::value_ptr(matrix));
+    this->SetMatrix4(this->Uniform(name), matrix, useShader);
+}
+
+ProgramState::UniformSlot *Shader::changed(UniformHandle handle, const void *value, std::size_t count)
+{
+    if (!handle.Valid() || !this->state)
+        return nullptr;
+    ProgramState::UniformSlot &entry = this->state->Uniforms[handle.Index];
+    if (entry.Known && std::memcmp(entry.Value, value, count * sizeof(float)) == 0)
+        return nullptr;
+    std::memcpy(entry.Value, value, count * sizeof(float));
+    entry.Known = true;
+    return &entry;
+}
+
+bool Shader::finishLink() const
+{
+    ProgramState &state = *this->state;
+    if (!state.Pending)
+        return state.Linked;
+    state.Pending = false;
+    static const char *stageNames[3] = { "VERTEX", "FRAGMENT", "GEOMETRY" };
+    for (int stage = 0; stage < 3; ++stage)
+        if (state.Stages[stage] != 0)
+            checkCompileErrors(state.Stages[stage], stageNames[stage]);
+    checkCompileErrors(this->ID, "PROGRAM");
+    int success;
+    glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+    state.Linked = success != 0;
+    if (state.Linked)
+        this->buildUniformTable();
+    // delete the shaders as they're linked into our program now and no longer necessary
+    for (unsigned int &stage : state.Stages)
+    {
+        if (stage != 0)
+            glDeleteShader(stage);
+        stage = 0;
+    }
+    return state.Linked;
+}
+
+void Shader::buildUniformTable() const
+{
+    for (auto &blockBinding : blockBindings)
+    {
+        GLuint index = glGetUniformBlockIndex(this->ID, blockBinding.first.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(this->ID, index, blockBinding.second);
+    }
+    ProgramState &state = *this->state;
+    // slots of uniforms the program no longer has stay behind with no location
+    std::vector<bool> seen(state.Uniforms.size(), false);
+    for (ProgramState::UniformSlot &slot : state.Uniforms)
+        slot.Location = -1;
+    GLint count = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        char name[256];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(this->ID, i, sizeof(name), &length, &size, &type, name);
+        GLint location = glGetUniformLocation(this->ID, name);
+        // members of uniform blocks have no location of their own
+        if (location < 0)
+            continue;
+        // arrays are reported as "name[0]": the plain name and "name[0]" share the first element's slot,
+        // every other element gets a slot of its own so looking it up by string keeps working
+        bool array = length > 3 && std::strcmp(name + length - 3, "[0]") == 0;
+        if (array)
+            name[length - 3] = '\0';
+        int slot = this->registerUniform(name, location, type, seen);
+        if (!array || slot < 0)
+            continue;
+        std::string base(name);
+        std::uint32_t first = Fnv1a((base + "[0]").c_str());
+        auto alias = std::lower_bound(state.Lookup.begin(), state.Lookup.end(), std::make_pair(first, -1));
+        if (alias == state.Lookup.end() || alias->first != first)
+            state.Lookup.insert(alias, std::make_pair(first, slot));
+        for (GLint element = 1; element < size; ++element)
+        {
+            std::string elementName = base + "[" + std::to_string(element) + "]";
+            this->registerUniform(elementName.c_str(), glGetUniformLocation(this->ID, elementName.c_str()), type, seen);
+        }
+    }
+}
+
+int Shader::registerUniform(const char *name, GLint location, GLenum type, std::vector<bool> &seen) const
+{
+    ProgramState &state = *this->state;
+    std::uint32_t hash = Fnv1a(name);
+    auto entry = std::lower_bound(state.Lookup.begin(), state.Lookup.end(), std::make_pair(hash, -1));
+    if (entry != state.Lookup.end() && entry->first == hash)
+    {
+        if (seen[entry->second])
+        {
+            std::cout << "| ERROR::SHADER: Two uniforms share the name hash " << hash << std::endl;
+            return -1;
+        }
+        ProgramState::UniformSlot &slot = state.Uniforms[entry->second];
+        // a changed type makes the shadow value meaningless
+        if (slot.Type != type)
+            slot.Known = false;
+        slot.Location = location;
+        slot.Type = type;
+        seen[entry->second] = true;
+        return entry->second;
+    }
+    int index = static_cast<int>(state.Uniforms.size());
+    ProgramState::UniformSlot slot = { hash, location, type, false, {} };
+    state.Lookup.insert(entry, std::make_pair(hash, index));
+    seen.push_back(true);
+    state.Uniforms.push_back(slot);
+    return index;
+}
+
+void Shader::upload(const ProgramState::UniformSlot &slot)
+{
+    GLint integer;
+    switch (slot.Type)
+    {
+    case GL_FLOAT:      glUniform1fv(slot.Location, 1, slot.Value); break;
+    case GL_FLOAT_VEC2: glUniform2fv(slot.Location, 1, slot.Value); break;
+    case GL_FLOAT_VEC3: glUniform3fv(slot.Location, 1, slot.Value); break;
+    case GL_FLOAT_VEC4: glUniform4fv(slot.Location, 1, slot.Value); break;
+    case GL_FLOAT_MAT4: glUniformMatrix4fv(slot.Location, 1, GL_FALSE, slot.Value); break;
+    default:
+        // ints, bools and samplers, all set through SetInteger
+        std::memcpy(&integer, slot.Value, sizeof(integer));
+        glUniform1i(slot.Location, integer);
+        break;
+    }
 }
 
 
@@ -9,28 +9,123 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "hash.h"
+
+
+// A uniform identified by the FNV-1a hash of its name. Declared
+// constexpr (e.g. static constexpr UniformID MODEL("model")) the hash
+// is computed by the compiler.
+struct UniformID
+{
+    std::uint32_t Hash;
+    explicit constexpr UniformID(const char *name) : Hash(Fnv1a(name)) { }
+};
+
+// A pre-resolved uniform of one particular shader, see Shader::Uniform.
+// Setting an invalid handle (a uniform the program doesn't use) is a no-op.
+struct UniformHandle
+{
+    int Index;
+    bool Valid() const { return this->Index >= 0; }
+};
+
+// Link state of a Shader's program: its active uniforms (enumerated
+// after linking, each with a shadow copy of its last uploaded value)
+// and, while a deferred link is pending, the shader objects whose
+// status hasn't been checked yet. Uniform slots never move, so handles
+// stay valid when Replace swaps in a rebuilt program.
+struct ProgramState
+{
+    struct UniformSlot
+    {
+        std::uint32_t Hash;
+        GLint         Location;   // -1 if the current program doesn't use the uniform (anymore)
+        GLenum        Type;
+        bool          Known;      // false until the first upload, so that one always happens
+        float         Value[16];  // raw bits of the last uploaded value
+    };
+    std::vector<UniformSlot> Uniforms;          // in order of first appearance, indexed by UniformHandle
+    std::vector<std::pair<std::uint32_t, int>> Lookup;  // (name hash, slot index), sorted by hash
+    bool                     Pending = false;   // submitted, compile/link status not checked yet
+    bool                     Linked = false;
+    unsigned int             Stages[3] = { 0, 0, 0 };
+};
 
 // General purpsoe shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
-// functions for easy management.
+// functions for easy management. Uniform locations are looked up once
+// at link time; setters skip uploads of values the program already
+// holds. A Shader owns its program: it is move-only, the program is
+// only created by Submit/Compile/LoadBinary and deleted with the object.
+// Code that draws with a shader keeps a reference to the owner (e.g.
+// the one in ResourceManager::Shaders), which also sees hot-reloads.
+// Submit starts compiling and linking without waiting for the driver;
+// the status checks are deferred until Finish or the first use, so
+// many programs can compile in parallel (GL_KHR_parallel_shader_compile).
+// Replace swaps a rebuilt program in under the same Shader object.
 class Shader
 {
 public:
     // state
-    unsigned int ID; 
-    // constructor
-    Shader() { }
+    unsigned int ID; // 0 until a program was created
+    // constructor (no GL calls)
+    Shader() : ID(0) { }
+    // destructor (deletes the program)
+    ~Shader();
+    // move only, ownership of the program moves along
+    Shader(Shader &&other) noexcept;
+    Shader &operator=(Shader &&other) noexcept;
+    Shader(const Shader &) = delete;
+    Shader &operator=(const Shader &) = delete;
     // sets the current shader as active
     Shader  &Use();
     // compiles the shader from given source code
     void    Compile(const char *vertexSource, const char *fragmentSource, const char *geometrySource = nullptr); // note: geometry source code is optional 
-    // utility functions
+    // starts compiling and linking without checking the result
+    void    Submit(const char *vertexSource, const char *fragmentSource, const char *geometrySource = nullptr);
+    // true once a submitted program can be finished without blocking (always true without parallel compile support)
+    bool    IsReady() const;
+    // checks (waiting if necessary) the compile/link status of a submitted program; returns true if it linked
+    bool    Finish();
+    // swaps the linked program of fresh in for this shader, keeping uniform handles and values; the old program is deleted
+    bool    Replace(Shader &fresh);
+    // binds the uniform block named block of every program linked from now on to a uniform buffer binding point
+    static void BindUniformBlock(const char *block, unsigned int binding);
+    // asks the driver for background compiler threads; returns false if GL_KHR_parallel_shader_compile is unavailable
+    static bool EnableParallelCompile();
+    // creates the program from a binary returned by GetBinary; false if the driver rejects it
+    bool    LoadBinary(GLenum format, const void *binary, GLsizei length);
+    // retrieves the linked program's binary (GL 4.1+); false if unavailable
+    bool    GetBinary(GLenum &format, std::vector<char> &binary) const;
+    // resolves a uniform once so it can be set without any lookup
+    UniformHandle Uniform(UniformID id) const;
+    UniformHandle Uniform(const char *name) const;
+    // utility functions, by handle (fastest), by hashed name, or by string (slow path)
+    void    SetFloat    (UniformHandle handle, float value, bool useShader = false);
+    void    SetInteger  (UniformHandle handle, int value, bool useShader = false);
+    void    SetVector2f (UniformHandle handle, float x, float y, bool useShader = false);
+    void    SetVector2f (UniformHandle handle, const glm::vec2 &value, bool useShader = false);
+    void    SetVector3f (UniformHandle handle, float x, float y, float z, bool useShader = false);
+    void    SetVector3f (UniformHandle handle, const glm::vec3 &value, bool useShader = false);
+    void    SetVector4f (UniformHandle handle, float x, float y, float z, float w, bool useShader = false);
+    void    SetVector4f (UniformHandle handle, const glm::vec4 &value, bool useShader = false);
+    void    SetMatrix4  (UniformHandle handle, const glm::mat4 &matrix, bool useShader = false);
+    void    SetFloat    (UniformID id, float value, bool useShader = false) { this->SetFloat(this->Uniform(id), value, useShader); }
+    void    SetInteger  (UniformID id, int value, bool useShader = false) { this->SetInteger(this->Uniform(id), value, useShader); }
+    void    SetVector2f (UniformID id, const glm::vec2 &value, bool useShader = false) { this->SetVector2f(this->Uniform(id), value, useShader); }
+    void    SetVector3f (UniformID id, const glm::vec3 &value, bool useShader = false) { this->SetVector3f(this->Uniform(id), value, useShader); }
+    void    SetVector4f (UniformID id, const glm::vec4 &value, bool useShader = false) { this->SetVector4f(this->Uniform(id), value, useShader); }
+    void    SetMatrix4  (UniformID id, const glm::mat4 &matrix, bool useShader = false) { this->SetMatrix4(this->Uniform(id), matrix, useShader); }
     void    SetFloat    (const char *name, float value, bool useShader = false);
     void    SetInteger  (const char *name, int value, bool useShader = false);
     void    SetVector2f (const char *name, float x, float y, bool useShader = false);
@@ -41,8 +136,26 @@ public:
     void    SetVector4f (const char *name, const glm::vec4 &value, bool useShader = false);
     void    SetMatrix4  (const char *name, const glm::mat4 &matrix, bool useShader = false);
 private:
+    // uniform locations, shadow values and link state (nullptr until a program was created)
+    std::unique_ptr<ProgramState> state;
+    // true if the driver compiles in the background
+    static bool parallelCompile;
+    // uniform block bindings applied to every program after linking
+    static std::vector<std::pair<std::string, unsigned int>> blockBindings;
     // checks if compilation or linking failed and if so, print the error logs
-    void    checkCompileErrors(unsigned int object, std::string type); 
+    static void checkCompileErrors(unsigned int object, std::string type); 
+    // deletes the program and any shader objects of a pending link
+    void    release();
+    // performs the deferred status checks of a submitted program
+    bool    finishLink() const;
+    // (re)builds the uniform table from the program's active uniforms and applies the uniform block bindings
+    void    buildUniformTable() const;
+    // points name at a slot, reusing the one it had in a previous build; returns the slot index, or -1 if another uniform of this build took the name hash
+    int     registerUniform(const char *name, GLint location, GLenum type, std::vector<bool> &seen) const;
+    // uploads the shadow value of slot to the bound program
+    static void upload(const ProgramState::UniformSlot &slot);
+    // returns the uniform slot of handle if its value differs from the count floats at value, and records value as the new shadow
+    ProgramState::UniformSlot *changed(UniformHandle handle, const void *value, std::size_t count);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,94 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "simulation_thread.h"
+
+#include <algorithm>
+#include <chrono>
+
+
+void StageTimings::Add(double seconds)
+{
+    ++this->Count;
+    this->TotalSeconds += seconds;
+    this->MaxSeconds = std::max(this->MaxSeconds, seconds);
+}
+
+
+SimulationThread::SimulationThread(Game &game, const FixedTimestep &timestep)
+    : game(game), timestep(timestep), timings(), stopping(false), acquired(false)
+{
+
+}
+
+SimulationThread::~SimulationThread()
+{
+    this->Stop();
+}
+
+void SimulationThread::Start()
+{
+    if (this->thread.joinable())
+        return;
+    SimulationFrame &frame = this->frames.Back();
+    this->game.Snapshot(frame.Current);
+    frame.Previous = frame.Current;
+    frame.Time = glfwGetTime();
+    this->frames.Publish();
+    this->stopping.store(false);
+    this->thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::Stop()
+{
+    this->stopping.store(true);
+    if (this->thread.joinable())
+        this->thread.join();
+}
+
+bool SimulationThread::Acquire()
+{
+    if (this->frames.Acquire())
+        this->acquired = true;
+    return this->acquired;
+}
+
+float SimulationThread::Alpha(double now) const
+{
+    // the newest state is shown one tick late, blending in over the tick that follows it
+    return static_cast<float>(std::min(1.0, std::max(0.0, (now - this->Frame().Time) / this->timestep.Step())));
+}
+
+void SimulationThread::run()
+{
+    GameSnapshot current = this->frames.Back().Current;
+    double last = glfwGetTime();
+    while (!this->stopping.load())
+    {
+        double now = glfwGetTime();
+        unsigned int ticks = this->timestep.Advance(now - last);
+        last = now;
+        for (unsigned int tick = 0; tick < ticks; ++tick)
+        {
+            auto start = std::chrono::steady_clock::now();
+            GameSnapshot previous = current;
+            this->game.ProcessInput(static_cast<float>(this->timestep.Step()), this->timestep.TickTime(now, tick, ticks));
+            this->game.Update(static_cast<float>(this->timestep.Step()));
+            this->game.Snapshot(current);
+            SimulationFrame &frame = this->frames.Back();
+            frame.Previous = previous;
+            frame.Current = current;
+            frame.Time = glfwGetTime();
+            this->frames.Publish();
+            this->timings.Add(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        // sleep until the next tick is due instead of spinning on the clock
+        double wait = (1.0 - this->timestep.Alpha()) * this->timestep.Step();
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include <atomic>
+#include <thread>
+
+#include "fixed_timestep.h"
+#include "game.h"
+#include "triple_buffer.h"
+
+
+// Time spent in one stage of the frame pipeline
+struct StageTimings
+{
+    unsigned long long Count;
+    double             TotalSeconds;
+    double             MaxSeconds;
+    void   Add(double seconds);
+    double AverageMilliseconds() const { return this->Count > 0 ? this->TotalSeconds * 1000.0 / this->Count : 0.0; }
+};
+
+// What the simulation publishes after every tick: the last two game
+// states, so the renderer can interpolate, and when the newer one was
+// produced (glfwGetTime seconds).
+struct SimulationFrame
+{
+    GameSnapshot Previous;
+    GameSnapshot Current;
+    double       Time;
+};
+
+// Runs the game's input and update ticks on a thread of their own, on
+// a fixed timestep, while the main thread keeps the GL context and only
+// renders. Every tick publishes an immutable SimulationFrame through a
+// triple buffer, so neither side ever waits for the other: a frame
+// costs max(simulation, rendering) instead of their sum. The game must
+// only touch its simulation state in ProcessInput and Update and only
+// read the snapshot in Render.
+class SimulationThread
+{
+public:
+    // constructor (does not start the thread)
+    SimulationThread(Game &game, const FixedTimestep &timestep);
+    // destructor (stops the thread)
+    ~SimulationThread();
+    // publishes the game's current state and starts ticking
+    void        Start();
+    // stops ticking and joins the thread
+    void        Stop();
+    // render thread: takes the newest published frame if there is one, returns false until the first one
+    bool        Acquire();
+    // render thread: the frame taken by the last Acquire
+    const SimulationFrame &Frame() const { return this->frames.Front(); }
+    // blend factor between Frame().Previous and Frame().Current at time now
+    float       Alpha(double now) const;
+    // seconds per tick
+    double      Step() const { return this->timestep.Step(); }
+    // simulation counters; only read them after Stop
+    const FixedTimestep &Timestep() const { return this->timestep; }
+    const StageTimings  &Timings() const { return this->timings; }
+private:
+    Game                          &game;
+    FixedTimestep                  timestep;
+    TripleBuffer<SimulationFrame>  frames;
+    StageTimings                   timings;
+    std::atomic<bool>              stopping;
+    bool                           acquired;
+    std::thread                    thread;
+    // thread body
+    void run();
+    // disable copying, the object owns a thread
+    SimulationThread(const SimulationThread &) = delete;
+    SimulationThread &operator=(const SimulationThread &) = delete;
+};
+
+#endif
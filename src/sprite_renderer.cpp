@@ -7,49 +7,150 @@
 ** option) any later version.
 ******************************************************************/
 #include "sprite_renderer.h"
+#include "gl_state.h"
 
+#include <cstddef>
+#include <cstring>
+#include <iostream>
 
-SpriteRenderer::SpriteRenderer(Shader shader)
+
+SpriteRenderer::SpriteRenderer(Shader &shader)
+    : instancedShader(nullptr), arrayShader(nullptr), hasArrayShader(false), batching(false), instanceVAO(0), instanceStream(nullptr), batchTexture(0), batchTarget(GL_TEXTURE_2D)
 {
-    this->shader = shader;
+    this->shader = &shader;
     this->initRenderData();
 }
 
-SpriteRenderer::~SpriteRenderer()
+SpriteRenderer::SpriteRenderer(Shader &shader, Shader &instancedShader)
+    : arrayShader(nullptr), hasArrayShader(false), batching(true), instanceVAO(0), instanceStream(nullptr), batchTexture(0), batchTarget(GL_TEXTURE_2D)
 {
-    glDeleteVertexArrays(1, &this->quadVAO);
+    this->shader = &shader;
+    this->instancedShader = &instancedShader;
+    this->initRenderData();
+    this->initBatchData();
 }
 
-void SpriteRenderer::DrawSprite(Texture2D texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+SpriteRenderer::SpriteRenderer(Shader &shader, Shader &instancedShader, Shader &arrayShader)
+    : SpriteRenderer(shader, instancedShader)
 {
-    // prepare transformations
-    this->shader.Use();
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(position, 0.0f));  // first translate (transformations are: scale happens first, then rotation, and then final translation happens; reversed order)
-
-    model = glm::translate(model, glm::vec3(.5f * size.x, 0.5f * size.y, 0.0f)); // move origin of rotation to center of quad
-    model = glm::rotate(model, glm::radians(rotate), glm::vec3(0.0f, 0.0f, 1.0f)); // then rotate
-    model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f)); // move origin back
+    this->arrayShader = &arrayShader;
+    this->hasArrayShader = true;
+}
 
-    model = glm::scale(model, glm::vec3(size, 1.0f)); // last scale
+SpriteRenderer::~SpriteRenderer()
+{
+    GLState::DeleteVertexArray(this->quadVAO);
+    GLState::DeleteBuffer(this->quadVBO);
+    if (this->instanceVAO != 0)
+    {
+        GLState::DeleteVertexArray(this->instanceVAO);
+        delete this->instanceStream;
+    }
+}
 
-    this->shader.SetMatrix4("model", model);
+void SpriteRenderer::Submit(const SpriteCommand &command)
+{
+    if (command.Target == GL_TEXTURE_2D_ARRAY && (!this->batching || !this->hasArrayShader))
+    {
+        std::cout << "ERROR::SPRITE_RENDERER: Array textures need a batching renderer with an array shader" << std::endl;
+        return;
+    }
+    this->stats.Sprites++;
+    if (this->batching)
+    {
+        // a batch can only sample one texture, so a texture change (or a full batch) ends it
+        if (!this->instances.empty() && (command.Texture != this->batchTexture || command.Target != this->batchTarget || this->instances.size() >= MAX_BATCH_INSTANCES))
+            this->Flush();
+        this->batchTexture = command.Texture;
+        this->batchTarget = command.Target;
+        this->positionsX.push_back(command.Position.x);
+        this->positionsY.push_back(command.Position.y);
+        this->widths.push_back(command.Size.x);
+        this->heights.push_back(command.Size.y);
+        this->rotations.push_back(glm::radians(command.Rotate));
+        this->instances.push_back({ SpriteAffine(), glm::vec4(command.Color, command.Layer), command.UVRect });
+        return;
+    }
+    // prepare transformations: scale, rotate around the quad's center, then translate
+    this->shader->Use();
+    glm::mat4 model = SpriteAffineToMat4(ComputeSpriteAffine(command.Position, command.Size, glm::radians(command.Rotate)));
+    this->shader->SetMatrix4(this->modelUniform, model);
 
     // render textured quad
-    this->shader.SetVector3f("spriteColor", color);
+    this->shader->SetVector3f(this->colorUniform, command.Color);
+    this->shader->SetVector4f(this->uvRectUniform, command.UVRect);
 
-    glActiveTexture(GL_TEXTURE0);
-    texture.Bind();
+    GLState::BindTexture(0, GL_TEXTURE_2D, command.Texture);
 
-    glBindVertexArray(this->quadVAO);
+    GLState::BindVertexArray(this->quadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    this->stats.DrawCalls++;
+}
+
+void SpriteRenderer::SetBlend(BlendMode blend)
+{
+    // draws queued so far were recorded under the old blend state
+    this->Flush();
+    switch (blend)
+    {
+    case BLEND_OPAQUE:
+        GLState::Blend(false);
+        break;
+    case BLEND_ADDITIVE:
+        GLState::Blend(true);
+        GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE);
+        break;
+    case BLEND_PREMULTIPLIED:
+        GLState::Blend(true);
+        GLState::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    default:
+        GLState::Blend(true);
+        GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    }
+    this->stats.BlendChanges++;
+}
+
+void SpriteRenderer::Flush()
+{
+    if (this->instances.empty())
+        return;
+    GLsizei count = static_cast<GLsizei>(this->instances.size());
+    // transform the whole batch in one go, straight into the instance records
+    SpriteTransformInput placements = { this->positionsX.data(), this->positionsY.data(), this->widths.data(), this->heights.data(), this->rotations.data() };
+    ComputeSpriteAffines(placements, this->instances.size(), &this->instances[0].Transform, sizeof(SpriteInstance));
+    this->clearPlacements();
+    GLsizeiptr bytes = count * sizeof(SpriteInstance);
+    // stream the instances into the ring; the returned offset tells where they landed
+    void *dst = this->instanceStream->Map(bytes);
+    if (dst == nullptr)
+    {
+        this->instances.clear();
+        return;
+    }
+    std::memcpy(dst, this->instances.data(), bytes);
+    GLintptr offset = this->instanceStream->Unmap();
+
+    this->UseInstancedShader(this->batchTarget);
+    GLState::BindTexture(0, this->batchTarget, this->batchTexture);
+
+    GLState::BindVertexArray(this->instanceVAO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, this->instanceStream->ID);
+    this->pointInstanceAttributes(offset);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+    this->stats.DrawCalls++;
+
+    this->instances.clear();
 }
 
 void SpriteRenderer::initRenderData()
 {
+    this->modelUniform = this->shader->Uniform("model");
+    this->colorUniform = this->shader->Uniform("spriteColor");
+    this->uvRectUniform = this->shader->Uniform("uvRect");
+
     // configure VAO/VBO
-    unsigned int VBO;
     float vertices[] = { 
         // pos      // tex
         0.0f, 1.0f, 0.0f, 1.0f,
@@ -61,15 +162,72 @@ void SpriteRenderer::initRenderData()
         1.0f, 0.0f, 1.0f, 0.0f
     };
 
-    glGenVertexArrays(1, &this->quadVAO);
-    glGenBuffers(1, &VBO);
+    this->quadVAO = GLState::GenVertexArray();
+    this->quadVBO = GLState::GenBuffer();
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    glBindVertexArray(this->quadVAO);
+    GLState::BindVertexArray(this->quadVAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+}
+
+void SpriteRenderer::initBatchData()
+{
+    this->instances.reserve(MAX_BATCH_INSTANCES);
+    this->positionsX.reserve(MAX_BATCH_INSTANCES);
+    this->positionsY.reserve(MAX_BATCH_INSTANCES);
+    this->widths.reserve(MAX_BATCH_INSTANCES);
+    this->heights.reserve(MAX_BATCH_INSTANCES);
+    this->rotations.reserve(MAX_BATCH_INSTANCES);
+
+    this->instanceVAO = GLState::GenVertexArray();
+    // room for a few full batches per region before the ring has to move on
+    this->instanceStream = new StreamBuffer(GL_ARRAY_BUFFER, 4 * MAX_BATCH_INSTANCES * sizeof(SpriteInstance));
+
+    GLState::BindVertexArray(this->instanceVAO);
+    // Flush re-points the per-instance attributes at the streamed data
+    this->SetupInstancedAttributes(this->instanceStream->ID);
+}
+
+void SpriteRenderer::SetupInstancedAttributes(unsigned int instanceBuffer) const
+{
+    // per-vertex quad, shared with the non-batched path
+    GLState::BindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    // per-instance transform rows, color/layer and uv rect, advanced once per sprite
+    GLState::BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (GLuint attribute = 1; attribute <= 4; ++attribute)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    pointInstanceAttributes(0);
+}
+
+void SpriteRenderer::UseInstancedShader(GLenum target) const
+{
+    if (target == GL_TEXTURE_2D_ARRAY)
+        this->arrayShader->Use();
+    else
+        this->instancedShader->Use();
+}
+
+void SpriteRenderer::pointInstanceAttributes(GLintptr offset)
+{
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(offset + offsetof(SpriteInstance, Transform) + offsetof(SpriteAffine, Row0)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(offset + offsetof(SpriteInstance, Transform) + offsetof(SpriteAffine, Row1)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(offset + offsetof(SpriteInstance, Color)));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(offset + offsetof(SpriteInstance, UVRect)));
+}
+
+void SpriteRenderer::clearPlacements()
+{
+    this->positionsX.clear();
+    this->positionsY.clear();
+    this->widths.clear();
+    this->heights.clear();
+    this->rotations.clear();
 }
\ No newline at end of file
@@ -9,29 +9,87 @@
 #ifndef SPRITE_RENDERER_H
 #define SPRITE_RENDERER_H
 
+#include <vector>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "render_backend.h"
 #include "texture.h"
+#include "texture_atlas.h"
 #include "shader.h"
+#include "stream_buffer.h"
+#include "sprite_transform.h"
+
 
+// Per-instance data of a batched sprite, laid out exactly as the
+// instanced sprite vertex shader expects it (attributes 1 to 4).
+struct SpriteInstance
+{
+    SpriteAffine Transform; // unit quad to screen space
+    glm::vec4    Color;     // <vec3 color, float array texture layer>
+    glm::vec4    UVRect;    // <vec2 offset, vec2 size> of the texture region
+};
 
-class SpriteRenderer
+// The OpenGL RenderBackend: draws every sprite right away, or batches
+// them into instanced draw calls if it has an instanced shader.
+class SpriteRenderer : public RenderBackend
 {
 public:
-    // Constructor (inits shaders/shapes)
-    SpriteRenderer(Shader shader);
+    // maximum number of sprites drawn by a single instanced draw call
+    static const unsigned int MAX_BATCH_INSTANCES = 4096;
+    // Constructor (inits shaders/shapes); the shaders are referenced, not copied, and must outlive the renderer
+    SpriteRenderer(Shader &shader);
+    // Constructor for batched rendering; instancedShader is the INSTANCED permutation of shaders/sprite
+    SpriteRenderer(Shader &shader, Shader &instancedShader);
+    // Constructor for batched rendering that can also draw array textures; arrayShader is the INSTANCED + ARRAY_TEXTURE permutation
+    SpriteRenderer(Shader &shader, Shader &instancedShader, Shader &arrayShader);
     // Destructor
     ~SpriteRenderer();
-    // Renders a defined quad textured with given sprite
-    void DrawSprite(Texture2D texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    // Renders a quad textured as command says; in batched mode the sprite is queued until the next Flush. Array textures need batched mode with an array shader
+    void Submit(const SpriteCommand &command) override;
+    // draws the queued sprites, then switches the GL blend state
+    void SetBlend(BlendMode blend) override;
+    // draws all queued sprites with a single instanced draw call; call at least once at the end of every frame
+    void Flush() override;
+    // true if DrawSprite calls are batched (only possible if an instanced shader was given)
+    bool IsBatching() const { return this->batching; }
+    // the ring buffer batched instance data is streamed through (nullptr if not batching)
+    const StreamBuffer *InstanceStream() const { return this->instanceStream; }
+    // true if instanced draws of textures of the given target are possible (batching, plus an array shader for GL_TEXTURE_2D_ARRAY)
+    bool CanDrawInstanced(GLenum target) const { return this->batching && (target != GL_TEXTURE_2D_ARRAY || this->hasArrayShader); }
+    // sets up the bound VAO for instanced draws: the renderer's quad per vertex, SpriteInstances from offset 0 of instanceBuffer per instance
+    void SetupInstancedAttributes(unsigned int instanceBuffer) const;
+    // activates the instanced program matching the texture target
+    void UseInstancedShader(GLenum target) const;
 private:
     // Render state
-    Shader       shader; 
+    Shader      *shader; 
+    Shader      *instancedShader;
+    Shader      *arrayShader;
+    bool         hasArrayShader;
     unsigned int quadVAO;
+    unsigned int quadVBO;
+    // uniforms of the immediate path, resolved once
+    UniformHandle modelUniform, colorUniform, uvRectUniform;
+    // Batch state
+    bool                        batching;
+    unsigned int                instanceVAO;
+    StreamBuffer               *instanceStream;
+    unsigned int                batchTexture;
+    GLenum                      batchTarget;   // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+    std::vector<SpriteInstance> instances;
+    // queued sprite placements in SoA form, turned into transforms all at once by Flush
+    std::vector<float>          positionsX, positionsY, widths, heights, rotations;
     // Initializes and configures the quad's buffer and vertex attributes
     void initRenderData();
+    // Initializes the instance buffer and the VAO used for batched draws
+    void initBatchData();
+    // points the per-instance attributes of the bound VAO at offset inside the bound instance buffer
+    static void pointInstanceAttributes(GLintptr offset);
+    // empties the queued SoA sprite placements
+    void clearPlacements();
 };
 
-#endif
\ No newline at end of file
+#endif
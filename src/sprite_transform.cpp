@@ -0,0 +1,99 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "sprite_transform.h"
+
+#include <cmath>
+
+#include <glm/simd/common.h>
+
+
+namespace
+{
+    // scalar kernel, used for the remainder of a batch and on targets without SIMD
+    inline void computeAffine(float x, float y, float width, float height, float rotation, SpriteAffine &out)
+    {
+        float s = std::sin(rotation);
+        float c = std::cos(rotation);
+        float halfWidth = 0.5f * width;
+        float halfHeight = 0.5f * height;
+        out.Row0 = glm::vec4(c * width, -s * height, x + halfWidth - c * halfWidth + s * halfHeight, 0.0f);
+        out.Row1 = glm::vec4(s * width, c * height, y + halfHeight - s * halfWidth - c * halfHeight, 0.0f);
+    }
+
+    inline SpriteAffine &at(SpriteAffine *out, std::size_t index, std::size_t stride)
+    {
+        return *reinterpret_cast<SpriteAffine*>(reinterpret_cast<unsigned char*>(out) + index * stride);
+    }
+}
+
+void ComputeSpriteAffines(const SpriteTransformInput &in, std::size_t count, SpriteAffine *out, std::size_t stride)
+{
+    std::size_t i = 0;
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+    const glm_vec4 half = _mm_set1_ps(0.5f);
+    const glm_vec4 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        // there is no SIMD sin/cos in glm, the trig pair stays scalar
+        alignas(16) float sines[4], cosines[4];
+        for (std::size_t lane = 0; lane < 4; ++lane)
+        {
+            sines[lane] = std::sin(in.Rotation[i + lane]);
+            cosines[lane] = std::cos(in.Rotation[i + lane]);
+        }
+        glm_vec4 s = _mm_load_ps(sines);
+        glm_vec4 c = _mm_load_ps(cosines);
+        glm_vec4 x = _mm_loadu_ps(in.X + i);
+        glm_vec4 y = _mm_loadu_ps(in.Y + i);
+        glm_vec4 width = _mm_loadu_ps(in.Width + i);
+        glm_vec4 height = _mm_loadu_ps(in.Height + i);
+        glm_vec4 halfWidth = glm_vec4_mul(half, width);
+        glm_vec4 halfHeight = glm_vec4_mul(half, height);
+
+        glm_vec4 m00 = glm_vec4_mul(c, width);
+        glm_vec4 m01 = glm_vec4_sub(zero, glm_vec4_mul(s, height));
+        glm_vec4 m02 = glm_vec4_add(glm_vec4_sub(glm_vec4_add(x, halfWidth), glm_vec4_mul(c, halfWidth)), glm_vec4_mul(s, halfHeight));
+        glm_vec4 m10 = glm_vec4_mul(s, width);
+        glm_vec4 m11 = glm_vec4_mul(c, height);
+        glm_vec4 m12 = glm_vec4_sub(glm_vec4_sub(glm_vec4_add(y, halfHeight), glm_vec4_mul(s, halfWidth)), glm_vec4_mul(c, halfHeight));
+
+        // lanes hold one coefficient of four sprites; transpose into one row per sprite
+        glm_vec4 w0 = zero, w1 = zero;
+        _MM_TRANSPOSE4_PS(m00, m01, m02, w0);
+        _MM_TRANSPOSE4_PS(m10, m11, m12, w1);
+        _mm_storeu_ps(&at(out, i + 0, stride).Row0.x, m00);
+        _mm_storeu_ps(&at(out, i + 1, stride).Row0.x, m01);
+        _mm_storeu_ps(&at(out, i + 2, stride).Row0.x, m02);
+        _mm_storeu_ps(&at(out, i + 3, stride).Row0.x, w0);
+        _mm_storeu_ps(&at(out, i + 0, stride).Row1.x, m10);
+        _mm_storeu_ps(&at(out, i + 1, stride).Row1.x, m11);
+        _mm_storeu_ps(&at(out, i + 2, stride).Row1.x, m12);
+        _mm_storeu_ps(&at(out, i + 3, stride).Row1.x, w1);
+    }
+#endif
+    for (; i < count; ++i)
+        computeAffine(in.X[i], in.Y[i], in.Width[i], in.Height[i], in.Rotation[i], at(out, i, stride));
+}
+
+SpriteAffine ComputeSpriteAffine(glm::vec2 position, glm::vec2 size, float rotation)
+{
+    SpriteAffine affine;
+    computeAffine(position.x, position.y, size.x, size.y, rotation, affine);
+    return affine;
+}
+
+glm::mat4 SpriteAffineToMat4(const SpriteAffine &affine)
+{
+    // column-major: the linear part goes into the first two columns, the translation into the last
+    return glm::mat4(
+        affine.Row0.x, affine.Row1.x, 0.0f, 0.0f,
+        affine.Row0.y, affine.Row1.y, 0.0f, 0.0f,
+        0.0f,          0.0f,          1.0f, 0.0f,
+        affine.Row0.z, affine.Row1.z, 0.0f, 1.0f);
+}
\ No newline at end of file
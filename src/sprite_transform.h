@@ -0,0 +1,48 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SPRITE_TRANSFORM_H
+#define SPRITE_TRANSFORM_H
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+
+// 2x3 affine transform that maps the unit quad (0..1, 0..1) of a sprite
+// to screen space: world = (dot(Row0.xyz, (u, v, 1)), dot(Row1.xyz, (u, v, 1))).
+// The w components are unused padding.
+struct SpriteAffine
+{
+    glm::vec4 Row0;
+    glm::vec4 Row1;
+};
+
+// Structure-of-arrays view of the sprites to transform; rotation is
+// in radians, around the center of the sprite.
+struct SpriteTransformInput
+{
+    const float *X;
+    const float *Y;
+    const float *Width;
+    const float *Height;
+    const float *Rotation;
+};
+
+// Computes the same transform as the translate/rotate/translate/scale
+// mat4 chain SpriteRenderer used to build, but for count sprites at
+// once and four at a time through glm's SIMD layer where available.
+// Results are written to out, stride bytes apart, so they can land
+// directly inside larger per-instance structs.
+void ComputeSpriteAffines(const SpriteTransformInput &in, std::size_t count, SpriteAffine *out, std::size_t stride = sizeof(SpriteAffine));
+// Single-sprite convenience version of ComputeSpriteAffines
+SpriteAffine ComputeSpriteAffine(glm::vec2 position, glm::vec2 size, float rotation);
+// Expands a sprite affine into the equivalent model matrix
+glm::mat4 SpriteAffineToMat4(const SpriteAffine &affine);
+
+#endif
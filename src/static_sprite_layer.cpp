@@ -0,0 +1,117 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "static_sprite_layer.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <iostream>
+
+
+StaticSpriteLayer::StaticSpriteLayer(SpriteRenderer &renderer, unsigned int texture, GLenum target)
+    : renderer(renderer), texture(texture), target(target), VAO(0), VBO(0), capacity(0), dirtyBegin(0), dirtyEnd(0), uploaded(0)
+{
+    if (!renderer.CanDrawInstanced(target))
+        std::cout << "ERROR::STATIC_SPRITE_LAYER: Renderer has no instanced shader for this texture target" << std::endl;
+    this->VAO = GLState::GenVertexArray();
+    this->VBO = GLState::GenBuffer();
+    GLState::BindVertexArray(this->VAO);
+    // per-vertex quad shared with the renderer, per-instance data from the layer's own buffer
+    renderer.SetupInstancedAttributes(this->VBO);
+}
+
+StaticSpriteLayer::~StaticSpriteLayer()
+{
+    GLState::DeleteVertexArray(this->VAO);
+    GLState::DeleteBuffer(this->VBO);
+}
+
+unsigned int StaticSpriteLayer::Add(const AtlasRegion &region, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+{
+    return this->add(region.UVRect, 0.0f, position, size, rotate, color);
+}
+
+unsigned int StaticSpriteLayer::Add(unsigned int arrayLayer, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+{
+    return this->add(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), static_cast<float>(arrayLayer), position, size, rotate, color);
+}
+
+void StaticSpriteLayer::Set(unsigned int index, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+{
+    if (index >= this->instances.size())
+    {
+        std::cout << "ERROR::STATIC_SPRITE_LAYER: Sprite index out of range: " << index << std::endl;
+        return;
+    }
+    SpriteInstance &instance = this->instances[index];
+    instance.Transform = ComputeSpriteAffine(position, size, glm::radians(rotate));
+    instance.Color = glm::vec4(color, instance.Color.a);
+    this->markDirty(index);
+}
+
+void StaticSpriteLayer::Hide(unsigned int index)
+{
+    if (index >= this->instances.size())
+    {
+        std::cout << "ERROR::STATIC_SPRITE_LAYER: Sprite index out of range: " << index << std::endl;
+        return;
+    }
+    // a zero transform collapses the quad to a point, so the rasterizer drops it
+    this->instances[index].Transform = SpriteAffine();
+    this->markDirty(index);
+}
+
+void StaticSpriteLayer::Draw()
+{
+    this->uploaded = 0;
+    if (this->instances.empty())
+        return;
+    GLsizei count = static_cast<GLsizei>(this->instances.size());
+    GLState::BindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    if (this->capacity < this->instances.size())
+    {
+        // the layer grew past its buffer: reallocate with headroom and upload everything
+        this->capacity = std::max<unsigned int>(64, static_cast<unsigned int>(this->instances.size()) * 2);
+        glBufferData(GL_ARRAY_BUFFER, this->capacity * sizeof(SpriteInstance), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(SpriteInstance), this->instances.data());
+        this->uploaded = count;
+    }
+    else if (this->dirtyBegin < this->dirtyEnd)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, this->dirtyBegin * sizeof(SpriteInstance), (this->dirtyEnd - this->dirtyBegin) * sizeof(SpriteInstance), &this->instances[this->dirtyBegin]);
+        this->uploaded = this->dirtyEnd - this->dirtyBegin;
+    }
+    this->dirtyBegin = this->dirtyEnd = 0;
+
+    // keep the draw order: anything the renderer still batches was submitted before the layer
+    this->renderer.Flush();
+    this->renderer.UseInstancedShader(this->target);
+    GLState::BindTexture(0, this->target, this->texture);
+    GLState::BindVertexArray(this->VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+}
+
+unsigned int StaticSpriteLayer::add(const glm::vec4 &uvRect, float layer, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+{
+    unsigned int index = static_cast<unsigned int>(this->instances.size());
+    this->instances.push_back({ ComputeSpriteAffine(position, size, glm::radians(rotate)), glm::vec4(color, layer), uvRect });
+    this->markDirty(index);
+    return index;
+}
+
+void StaticSpriteLayer::markDirty(unsigned int index)
+{
+    if (this->dirtyBegin == this->dirtyEnd)
+    {
+        this->dirtyBegin = index;
+        this->dirtyEnd = index + 1;
+        return;
+    }
+    this->dirtyBegin = std::min(this->dirtyBegin, index);
+    this->dirtyEnd = std::max(this->dirtyEnd, index + 1);
+}
\ No newline at end of file
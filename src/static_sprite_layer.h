@@ -0,0 +1,68 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef STATIC_SPRITE_LAYER_H
+#define STATIC_SPRITE_LAYER_H
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "sprite_renderer.h"
+#include "texture.h"
+#include "texture_atlas.h"
+
+
+// A retained set of sprites that all sample the same texture (an
+// atlas page or an array texture), e.g. the brick field of a level.
+// The sprites live in their own GPU instance buffer that is uploaded
+// once; every frame the whole layer is drawn with a single instanced
+// call. Changing or hiding a sprite only marks its instance dirty, and
+// the next Draw patches the dirty range instead of the whole buffer.
+class StaticSpriteLayer
+{
+public:
+    // constructor; texture is the GL name all sprites sample, target GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+    StaticSpriteLayer(SpriteRenderer &renderer, unsigned int texture, GLenum target = GL_TEXTURE_2D);
+    // destructor
+    ~StaticSpriteLayer();
+    // adds a sprite and returns its index inside the layer
+    unsigned int Add(const AtlasRegion &region, glm::vec2 position, glm::vec2 size, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    unsigned int Add(unsigned int arrayLayer, glm::vec2 position, glm::vec2 size, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    // moves/recolors a sprite
+    void         Set(unsigned int index, glm::vec2 position, glm::vec2 size, float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    // stops drawing a sprite (e.g. a destroyed brick); its slot stays reserved
+    void         Hide(unsigned int index);
+    // uploads pending changes and draws all sprites
+    void         Draw();
+    // number of sprites in the layer
+    unsigned int Size() const { return static_cast<unsigned int>(this->instances.size()); }
+    // number of instances uploaded by the last Draw (0 when nothing changed)
+    unsigned int UploadedInstances() const { return this->uploaded; }
+private:
+    SpriteRenderer              &renderer;
+    unsigned int                texture;
+    GLenum                      target;
+    unsigned int                VAO;
+    unsigned int                VBO;
+    unsigned int                capacity;   // instances the GL buffer has room for
+    std::vector<SpriteInstance> instances;
+    // half-open range of instances changed since the last upload
+    unsigned int                dirtyBegin, dirtyEnd;
+    unsigned int                uploaded;
+    // records a sprite instance
+    unsigned int add(const glm::vec4 &uvRect, float layer, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color);
+    // grows the dirty range to include index
+    void markDirty(unsigned int index);
+    // disable copying, the layer owns its GL buffer
+    StaticSpriteLayer(const StaticSpriteLayer &) = delete;
+    StaticSpriteLayer &operator=(const StaticSpriteLayer &) = delete;
+};
+
+#endif
@@ -0,0 +1,116 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "stream_buffer.h"
+#include "gl_state.h"
+
+#include <iostream>
+
+
+StreamBuffer::StreamBuffer(GLenum target, GLsizeiptr regionSize)
+    : target(target), regionSize(regionSize), persistent(false), mapped(nullptr), fences(), region(0), head(0), pendingOffset(0), pendingSize(0), stalls(0), regionSwitches(0)
+{
+    GLsizeiptr totalSize = regionSize * REGION_COUNT;
+    this->ID = GLState::GenBuffer();
+    GLState::BindBuffer(this->target, this->ID);
+    if (GLAD_GL_VERSION_4_4 && glBufferStorage != nullptr)
+    {
+        // immutable storage that stays mapped for the buffer's whole lifetime
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(this->target, totalSize, nullptr, flags);
+        this->mapped = static_cast<unsigned char*>(glMapBufferRange(this->target, 0, totalSize, flags));
+        this->persistent = this->mapped != nullptr;
+        if (!this->persistent)
+        {
+            std::cout << "WARNING::STREAM_BUFFER: Persistent mapping failed, falling back to orphaning" << std::endl;
+            // immutable storage can't be respecified, so start over with a fresh buffer
+            GLState::DeleteBuffer(this->ID);
+            this->ID = GLState::GenBuffer();
+            GLState::BindBuffer(this->target, this->ID);
+        }
+    }
+    if (!this->persistent)
+        glBufferData(this->target, totalSize, nullptr, GL_STREAM_DRAW);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (GLsync fence : this->fences)
+        if (fence != nullptr)
+            glDeleteSync(fence);
+    if (this->persistent)
+    {
+        GLState::BindBuffer(this->target, this->ID);
+        glUnmapBuffer(this->target);
+    }
+    GLState::DeleteBuffer(this->ID);
+}
+
+void *StreamBuffer::Map(GLsizeiptr size)
+{
+    if (size > this->regionSize)
+    {
+        std::cout << "ERROR::STREAM_BUFFER: Write of " << size << " bytes exceeds region size " << this->regionSize << std::endl;
+        return nullptr;
+    }
+    if (this->head + size > this->regionSize)
+        this->nextRegion();
+    this->pendingOffset = this->region * this->regionSize + this->head;
+    this->pendingSize = size;
+    this->head += size;
+    if (this->persistent)
+        return this->mapped + this->pendingOffset;
+    // fences guarantee the range is free (and the buffer was orphaned on wrap), so skip the driver's implicit sync
+    GLState::BindBuffer(this->target, this->ID);
+    return glMapBufferRange(this->target, this->pendingOffset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+GLintptr StreamBuffer::Unmap()
+{
+    // coherent persistent mappings need no explicit flush
+    if (!this->persistent)
+        glUnmapBuffer(this->target);
+    return this->pendingOffset;
+}
+
+void StreamBuffer::nextRegion()
+{
+    // every draw reading the current region has been issued by now
+    this->fences[this->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->region = (this->region + 1) % REGION_COUNT;
+    this->head = 0;
+    this->regionSwitches++;
+    if (this->region == 0 && !this->persistent)
+    {
+        // orphan: the driver hands us fresh storage while in-flight draws keep the old one
+        GLState::BindBuffer(this->target, this->ID);
+        glBufferData(this->target, this->regionSize * REGION_COUNT, nullptr, GL_STREAM_DRAW);
+        // every fence guards the old storage, nothing in the new one is in use
+        for (GLsync &pending : this->fences)
+        {
+            if (pending != nullptr)
+                glDeleteSync(pending);
+            pending = nullptr;
+        }
+        return;
+    }
+    GLsync fence = this->fences[this->region];
+    if (fence == nullptr)
+        return;
+    // poll first: if the GPU is done with the region there is no stall to report
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        this->stalls++;
+        do
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    this->fences[this->region] = nullptr;
+}
\ No newline at end of file
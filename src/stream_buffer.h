@@ -0,0 +1,63 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+
+// A ring buffer for streaming per-frame vertex/instance data to the
+// GPU. The buffer is split into REGION_COUNT regions; each region is
+// fenced once the writer moves past it and is only written again after
+// its fence signaled, so the CPU never overwrites data a draw call is
+// still reading. On GL 4.4+ the whole buffer is persistently mapped
+// (GL_ARB_buffer_storage), otherwise every write is an unsynchronized
+// glMapBufferRange and the buffer is orphaned whenever the ring wraps,
+// which drops the fences of the old storage instead of waiting on them.
+class StreamBuffer
+{
+public:
+    // number of regions the ring is split into (triple buffering)
+    static const unsigned int REGION_COUNT = 3;
+    // holds the ID of the buffer object
+    unsigned int ID;
+    // constructor (creates the buffer with REGION_COUNT * regionSize bytes of storage)
+    StreamBuffer(GLenum target, GLsizeiptr regionSize);
+    // destructor
+    ~StreamBuffer();
+    // returns a write pointer to size bytes of buffer storage; must be followed by Unmap before drawing
+    void       *Map(GLsizeiptr size);
+    // finishes the write started by Map and returns the byte offset of the written data inside the buffer
+    GLintptr    Unmap();
+    // true if the buffer is persistently mapped
+    bool        IsPersistent() const { return this->persistent; }
+    // number of times Map had to wait for the GPU to release a region
+    unsigned int Stalls() const { return this->stalls; }
+    // number of times the write head moved on to the next region
+    unsigned int RegionSwitches() const { return this->regionSwitches; }
+private:
+    GLenum        target;
+    GLsizeiptr    regionSize;
+    bool          persistent;
+    unsigned char *mapped;           // start of the persistent mapping
+    GLsync        fences[REGION_COUNT];
+    unsigned int  region;            // region currently written to
+    GLsizeiptr    head;              // write offset inside the current region
+    GLintptr      pendingOffset;     // buffer offset of the write started by Map
+    GLsizeiptr    pendingSize;
+    unsigned int  stalls;
+    unsigned int  regionSwitches;
+    // fences the current region and moves the write head to the start of the next one
+    void nextRegion();
+    // disable copying, the buffer owns its GL storage and mapping
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+};
+
+#endif
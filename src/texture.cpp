@@ -6,34 +6,160 @@
 ** Creative Commons, either version 4 of the License, or (at your
 ** option) any later version.
 ******************************************************************/
+#include <algorithm>
 #include <iostream>
 
 #include "texture.h"
+#include "gl_state.h"
 
 
 Texture2D::Texture2D()
-    : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR)
+    : ID(0), Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR), Premultiplied(false)
 {
-    glGenTextures(1, &this->ID);
+
+}
+
+Texture2D::~Texture2D()
+{
+    GLState::DeleteTexture(this->ID);
+}
+
+Texture2D::Texture2D(Texture2D &&other) noexcept
+    : ID(other.ID), Width(other.Width), Height(other.Height), Internal_Format(other.Internal_Format), Image_Format(other.Image_Format),
+      Wrap_S(other.Wrap_S), Wrap_T(other.Wrap_T), Filter_Min(other.Filter_Min), Filter_Max(other.Filter_Max), Premultiplied(other.Premultiplied)
+{
+    other.ID = 0;
+}
+
+Texture2D &Texture2D::operator=(Texture2D &&other) noexcept
+{
+    if (this != &other)
+    {
+        GLState::DeleteTexture(this->ID);
+        this->ID = other.ID;
+        this->Width = other.Width;
+        this->Height = other.Height;
+        this->Internal_Format = other.Internal_Format;
+        this->Image_Format = other.Image_Format;
+        this->Wrap_S = other.Wrap_S;
+        this->Wrap_T = other.Wrap_T;
+        this->Filter_Min = other.Filter_Min;
+        this->Filter_Max = other.Filter_Max;
+        this->Premultiplied = other.Premultiplied;
+        other.ID = 0;
+    }
+    return *this;
 }
 
 void Texture2D::Generate(unsigned int width, unsigned int height, unsigned char* data)
 {
+    this->Generate(width, height, 1, &data);
+}
+
+void Texture2D::Generate(unsigned int width, unsigned int height, unsigned int levels, const unsigned char* const *data)
+{
+    if (this->ID == 0)
+        this->ID = GLState::GenTexture();
     this->Width = width;
     this->Height = height;
     // create Texture
+    GLState::BindTexture(GL_TEXTURE_2D, this->ID);
+    this->specify(levels, data);
+}
+
+void Texture2D::Upload(unsigned int width, unsigned int height, unsigned int levels, const unsigned char* const *data)
+{
+    this->Width = width;
+    this->Height = height;
     glBindTexture(GL_TEXTURE_2D, this->ID);
-    glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
+    this->specify(levels, data);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture2D::specify(unsigned int levels, const unsigned char* const *data)
+{
+    for (unsigned int level = 0; level < levels; ++level)
+    {
+        GLsizei width = std::max(1u, this->Width >> level), height = std::max(1u, this->Height >> level);
+        glTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data[level]);
+    }
+    // sampling stops at the levels that were given, so a partial chain is still complete
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
     // set Texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->Wrap_T);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
-    // unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture2D::Bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    GLState::BindTexture(GL_TEXTURE_2D, this->ID);
+}
+
+
+Texture2DArray::Texture2DArray()
+    : ID(0), Width(0), Height(0), Layers(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_CLAMP_TO_EDGE), Wrap_T(GL_CLAMP_TO_EDGE), Filter_Min(GL_LINEAR_MIPMAP_LINEAR), Filter_Max(GL_LINEAR)
+{
+
+}
+
+Texture2DArray::~Texture2DArray()
+{
+    GLState::DeleteTexture(this->ID);
+}
+
+Texture2DArray::Texture2DArray(Texture2DArray &&other) noexcept
+    : ID(other.ID), Width(other.Width), Height(other.Height), Layers(other.Layers), Internal_Format(other.Internal_Format), Image_Format(other.Image_Format),
+      Wrap_S(other.Wrap_S), Wrap_T(other.Wrap_T), Filter_Min(other.Filter_Min), Filter_Max(other.Filter_Max)
+{
+    other.ID = 0;
+}
+
+Texture2DArray &Texture2DArray::operator=(Texture2DArray &&other) noexcept
+{
+    if (this != &other)
+    {
+        GLState::DeleteTexture(this->ID);
+        this->ID = other.ID;
+        this->Width = other.Width;
+        this->Height = other.Height;
+        this->Layers = other.Layers;
+        this->Internal_Format = other.Internal_Format;
+        this->Image_Format = other.Image_Format;
+        this->Wrap_S = other.Wrap_S;
+        this->Wrap_T = other.Wrap_T;
+        this->Filter_Min = other.Filter_Min;
+        this->Filter_Max = other.Filter_Max;
+        other.ID = 0;
+    }
+    return *this;
+}
+
+void Texture2DArray::Generate(unsigned int width, unsigned int height, unsigned int layers, unsigned char* data)
+{
+    if (this->ID == 0)
+        this->ID = GLState::GenTexture();
+    this->Width = width;
+    this->Height = height;
+    this->Layers = layers;
+    // create Texture
+    GLState::BindTexture(GL_TEXTURE_2D_ARRAY, this->ID);
+    // layers are stacked tightly packed, RGB rows of odd widths are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, this->Internal_Format, width, height, layers, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // mip levels are built per layer, so small sprites never pick up their neighbours
+    if (this->Filter_Min != GL_LINEAR && this->Filter_Min != GL_NEAREST)
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    // set Texture wrap and filter modes
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, this->Wrap_S);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, this->Wrap_T);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
+}
+
+void Texture2DArray::Bind() const
+{
+    GLState::BindTexture(GL_TEXTURE_2D_ARRAY, this->ID);
 }
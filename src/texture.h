@@ -11,12 +11,32 @@
 
 #include <glad/glad.h>
 
+// Non-owning references to a texture for draw calls. Copying one is
+// free and never touches GL; a view is only valid while the texture it
+// was taken from is alive.
+struct Texture2DView
+{
+    unsigned int ID;
+    unsigned int Width, Height;
+    bool         Premultiplied;
+};
+
+struct Texture2DArrayView
+{
+    unsigned int ID;
+    unsigned int Width, Height;
+    unsigned int Layers;
+};
+
 // Texture2D is able to store and configure a texture in OpenGL.
-// It also hosts utility functions for easy management.
+// It also hosts utility functions for easy management. A Texture2D
+// owns its GL texture: it is move-only, the name is only created by
+// Generate and it is deleted with the object. Pass Texture2DView
+// around instead of copies.
 class Texture2D
 {
 public:
-    // holds the ID of the texture object, used for all texture operations to reference to this particlar texture
+    // holds the ID of the texture object, used for all texture operations to reference to this particlar texture (0 until Generate)
     unsigned int ID;
     // texture image dimensions
     unsigned int Width, Height; // width and height of loaded image in pixels
@@ -28,12 +48,70 @@ public:
     unsigned int Wrap_T; // wrapping mode on T axis
     unsigned int Filter_Min; // filtering mode if texture pixels < screen pixels
     unsigned int Filter_Max; // filtering mode if texture pixels > screen pixels
-    // constructor (sets default texture modes)
+    // color channels are multiplied by alpha (a cooked .btex with BTEX_PREMULTIPLIED)
+    bool         Premultiplied;
+    // constructor (sets default texture modes, no GL calls)
     Texture2D();
-    // generates texture from image data
+    // destructor (deletes the texture object)
+    ~Texture2D();
+    // move only, ownership of the texture object moves along
+    Texture2D(Texture2D &&other) noexcept;
+    Texture2D &operator=(Texture2D &&other) noexcept;
+    Texture2D(const Texture2D &) = delete;
+    Texture2D &operator=(const Texture2D &) = delete;
+    // generates texture from image data (creating the texture object on first use)
     void Generate(unsigned int width, unsigned int height, unsigned char* data);
+    // same with a complete mip chain, data[i] holding level i (each level half the size of the previous one)
+    void Generate(unsigned int width, unsigned int height, unsigned int levels, const unsigned char* const *data);
+    // same for a shared context on another thread (UploadContext): binds with plain GL since GLState tracks the render thread's context; ID must already exist
+    void Upload(unsigned int width, unsigned int height, unsigned int levels, const unsigned char* const *data);
     // binds the texture as the current active GL_TEXTURE_2D texture object
     void Bind() const;
+    // non-owning reference for draw calls
+    Texture2DView View() const { return { this->ID, this->Width, this->Height, this->Premultiplied }; }
+    operator Texture2DView() const { return this->View(); }
+private:
+    // specifies the mip levels and parameters of the bound texture
+    void specify(unsigned int levels, const unsigned char* const *data);
+};
+
+// Texture2DArray is the GL_TEXTURE_2D_ARRAY sibling of Texture2D: a
+// stack of equally sized images (layers) that a shader selects from
+// with a layer index. Each layer is mipmapped on its own, so unlike an
+// atlas there is no bleeding between neighbouring images. Owns its GL
+// texture like Texture2D does.
+class Texture2DArray
+{
+public:
+    // holds the ID of the texture object (0 until Generate)
+    unsigned int ID;
+    // texture image dimensions
+    unsigned int Width, Height; // width and height of each layer in pixels
+    unsigned int Layers; // number of images in the array
+    // texture Format
+    unsigned int Internal_Format; // format of texture object
+    unsigned int Image_Format; // format of loaded images
+    // texture configuration
+    unsigned int Wrap_S; // wrapping mode on S axis
+    unsigned int Wrap_T; // wrapping mode on T axis
+    unsigned int Filter_Min; // filtering mode if texture pixels < screen pixels; mipmaps are generated for mipmap filters
+    unsigned int Filter_Max; // filtering mode if texture pixels > screen pixels
+    // constructor (sets default texture modes, no GL calls)
+    Texture2DArray();
+    // destructor (deletes the texture object)
+    ~Texture2DArray();
+    // move only, ownership of the texture object moves along
+    Texture2DArray(Texture2DArray &&other) noexcept;
+    Texture2DArray &operator=(Texture2DArray &&other) noexcept;
+    Texture2DArray(const Texture2DArray &) = delete;
+    Texture2DArray &operator=(const Texture2DArray &) = delete;
+    // generates the array from layers images stored back to back in data (creating the texture object on first use)
+    void Generate(unsigned int width, unsigned int height, unsigned int layers, unsigned char* data);
+    // binds the texture as the current active GL_TEXTURE_2D_ARRAY texture object
+    void Bind() const;
+    // non-owning reference for draw calls
+    Texture2DArrayView View() const { return { this->ID, this->Width, this->Height, this->Layers }; }
+    operator Texture2DArrayView() const { return this->View(); }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,196 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "texture_atlas.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+
+SkylinePacker::SkylinePacker(unsigned int width, unsigned int height)
+    : width(width), height(height)
+{
+    this->skyline.push_back({ 0, 0, width });
+}
+
+bool SkylinePacker::Insert(unsigned int width, unsigned int height, unsigned int &x, unsigned int &y)
+{
+    // bottom-left rule: lowest resting y wins, ties go to the narrowest segment
+    std::size_t best = this->skyline.size();
+    unsigned int bestY = 0, bestWidth = 0;
+    for (std::size_t i = 0; i < this->skyline.size(); ++i)
+    {
+        unsigned int restY;
+        if (!this->fit(i, width, height, restY))
+            continue;
+        if (best == this->skyline.size() || restY < bestY || (restY == bestY && this->skyline[i].Width < bestWidth))
+        {
+            best = i;
+            bestY = restY;
+            bestWidth = this->skyline[i].Width;
+        }
+    }
+    if (best == this->skyline.size())
+        return false;
+    x = this->skyline[best].X;
+    y = bestY;
+
+    // the new rectangle's top becomes a skyline segment that shadows the segments below it
+    Segment top = { x, y + height, width };
+    this->skyline.insert(this->skyline.begin() + best, top);
+    for (std::size_t i = best + 1; i < this->skyline.size(); )
+    {
+        Segment &segment = this->skyline[i];
+        unsigned int topEnd = top.X + top.Width;
+        if (segment.X >= topEnd)
+            break;
+        unsigned int segmentEnd = segment.X + segment.Width;
+        if (segmentEnd <= topEnd)
+        {
+            this->skyline.erase(this->skyline.begin() + i);
+            continue;
+        }
+        segment.Width = segmentEnd - topEnd;
+        segment.X = topEnd;
+        break;
+    }
+    // merge neighbours at the same height
+    for (std::size_t i = 0; i + 1 < this->skyline.size(); )
+    {
+        if (this->skyline[i].Y == this->skyline[i + 1].Y)
+        {
+            this->skyline[i].Width += this->skyline[i + 1].Width;
+            this->skyline.erase(this->skyline.begin() + i + 1);
+        }
+        else
+            ++i;
+    }
+    return true;
+}
+
+bool SkylinePacker::fit(std::size_t index, unsigned int width, unsigned int height, unsigned int &y) const
+{
+    unsigned int x = this->skyline[index].X;
+    if (x + width > this->width)
+        return false;
+    y = 0;
+    unsigned int remaining = width;
+    for (std::size_t i = index; remaining > 0; ++i)
+    {
+        if (i == this->skyline.size())
+            return false;
+        y = std::max(y, this->skyline[i].Y);
+        if (y + height > this->height)
+            return false;
+        remaining -= std::min(remaining, this->skyline[i].Width);
+    }
+    return true;
+}
+
+
+TextureAtlas::TextureAtlas(unsigned int pageSize, unsigned int padding)
+    : PageSize(pageSize), Padding(padding), images(0), usedPixels(0)
+{
+
+}
+
+AtlasRegion TextureAtlas::Add(unsigned int width, unsigned int height, const unsigned char *rgba)
+{
+    AtlasRegion region = { 0, 0, width, height, glm::vec4(0.0f), false };
+    if (width == 0 || height == 0)
+    {
+        std::cout << "ERROR::TEXTURE_ATLAS: Image of " << width << "x" << height << " is empty" << std::endl;
+        return region;
+    }
+    unsigned int blockWidth = width + 2 * this->Padding;
+    unsigned int blockHeight = height + 2 * this->Padding;
+    if (rgba == nullptr || blockWidth > this->PageSize || blockHeight > this->PageSize)
+    {
+        std::cout << "ERROR::TEXTURE_ATLAS: Image of " << width << "x" << height << " does not fit a " << this->PageSize << " page" << std::endl;
+        return region;
+    }
+    // first fit over the existing pages, open a new one if none has room
+    unsigned int x = 0, y = 0;
+    std::size_t page = 0;
+    while (page < this->packers.size() && !this->packers[page].Insert(blockWidth, blockHeight, x, y))
+        ++page;
+    if (page == this->packers.size())
+    {
+        this->addPage();
+        this->packers[page].Insert(blockWidth, blockHeight, x, y);
+    }
+
+    // build the padded block, extruding the image's outermost pixels into the border; it goes straight
+    // into the streamer's mapped buffer, or into client memory if it is too large for a ring region
+    unsigned char *block = this->streamer.Begin(this->pages[page], x, y, blockWidth, blockHeight, GL_RGBA);
+    std::vector<unsigned char> fallback;
+    if (block == nullptr)
+    {
+        fallback.resize(static_cast<std::size_t>(blockWidth) * blockHeight * 4);
+        block = fallback.data();
+    }
+    for (unsigned int by = 0; by < blockHeight; ++by)
+    {
+        unsigned int sy = std::min(height - 1, static_cast<unsigned int>(std::max(0, static_cast<int>(by) - static_cast<int>(this->Padding))));
+        for (unsigned int bx = 0; bx < blockWidth; ++bx)
+        {
+            unsigned int sx = std::min(width - 1, static_cast<unsigned int>(std::max(0, static_cast<int>(bx) - static_cast<int>(this->Padding))));
+            const unsigned char *src = rgba + (static_cast<std::size_t>(sy) * width + sx) * 4;
+            std::copy(src, src + 4, block + (static_cast<std::size_t>(by) * blockWidth + bx) * 4);
+        }
+    }
+    if (fallback.empty())
+        this->streamer.End();
+    else
+        this->streamer.Update(this->pages[page], x, y, blockWidth, blockHeight, GL_RGBA, block);
+
+    this->images++;
+    this->usedPixels += static_cast<std::size_t>(blockWidth) * blockHeight;
+    float size = static_cast<float>(this->PageSize);
+    region.Texture = this->pages[page].ID;
+    region.Page = static_cast<unsigned int>(page);
+    region.UVRect = glm::vec4((x + this->Padding) / size, (y + this->Padding) / size, width / size, height / size);
+    return region;
+}
+
+AtlasStats TextureAtlas::Stats() const
+{
+    AtlasStats stats;
+    stats.Pages = static_cast<unsigned int>(this->pages.size());
+    stats.Images = this->images;
+    stats.UsedPixels = this->usedPixels;
+    stats.TotalPixels = static_cast<std::size_t>(this->PageSize) * this->PageSize * stats.Pages;
+    stats.Bytes = stats.TotalPixels * 4;
+    stats.Occupancy = stats.TotalPixels > 0 ? static_cast<float>(stats.UsedPixels) / stats.TotalPixels : 0.0f;
+    return stats;
+}
+
+void TextureAtlas::Clear()
+{
+    // the pages delete their textures
+    this->pages.clear();
+    this->streamer.Clear();
+    this->packers.clear();
+    this->images = 0;
+    this->usedPixels = 0;
+}
+
+void TextureAtlas::addPage()
+{
+    Texture2D page;
+    page.Internal_Format = GL_RGBA;
+    page.Image_Format = GL_RGBA;
+    // sampling outside a region is what the extruded padding is for, so clamp the page itself
+    page.Wrap_S = GL_CLAMP_TO_EDGE;
+    page.Wrap_T = GL_CLAMP_TO_EDGE;
+    page.Generate(this->PageSize, this->PageSize, nullptr);
+    this->pages.push_back(std::move(page));
+    this->packers.push_back(SkylinePacker(this->PageSize, this->PageSize));
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.h"
+#include "texture_streamer.h"
+
+
+// A sub-rectangle of an atlas page. UVRect holds <vec2 offset, vec2 size>
+// in normalized texture coordinates, so a quad's texture coordinates t
+// map to UVRect.xy + t * UVRect.zw.
+struct AtlasRegion
+{
+    unsigned int Texture;  // GL name of the atlas page (0 if the image could not be packed)
+    unsigned int Page;     // index of the page inside its atlas
+    unsigned int Width, Height; // size of the packed image in pixels
+    glm::vec4    UVRect;
+    bool         Premultiplied; // color channels are multiplied by alpha
+};
+
+// Packing statistics of a TextureAtlas
+struct AtlasStats
+{
+    unsigned int Pages;
+    unsigned int Images;
+    std::size_t  UsedPixels;  // pixels covered by packed images including padding
+    std::size_t  TotalPixels; // pixels of all pages
+    std::size_t  Bytes;       // GPU memory of all pages
+    float        Occupancy;   // UsedPixels / TotalPixels
+};
+
+// Skyline bottom-left rectangle packer. Tracks the top edge of all
+// placed rectangles as a list of horizontal segments and places each
+// new rectangle as low as possible on it.
+class SkylinePacker
+{
+public:
+    SkylinePacker(unsigned int width, unsigned int height);
+    // finds a spot for a width x height rectangle; returns false if it doesn't fit
+    bool Insert(unsigned int width, unsigned int height, unsigned int &x, unsigned int &y);
+private:
+    struct Segment
+    {
+        unsigned int X, Y, Width;
+    };
+    unsigned int         width, height;
+    std::vector<Segment> skyline;
+    // returns the y a rectangle would rest at when its left edge starts at segment index, or false if it doesn't fit
+    bool fit(std::size_t index, unsigned int width, unsigned int height, unsigned int &y) const;
+};
+
+// Packs many small images into a few large RGBA texture pages so
+// sprites that use them can be drawn from a single texture. Every
+// image is surrounded by Padding pixels of its own extruded edge to
+// keep linear filtering from bleeding neighbours into it. Images are
+// written straight into a TextureStreamer's pixel buffer ring, so
+// adding one while the game runs doesn't wait for the copy.
+class TextureAtlas
+{
+public:
+    // page dimensions in pixels and border around each packed image
+    unsigned int PageSize;
+    unsigned int Padding;
+    // constructor (pages are only created once the first image is added)
+    TextureAtlas(unsigned int pageSize = 2048, unsigned int padding = 2);
+    // packs an RGBA image (4 bytes per pixel) and uploads it into a page
+    AtlasRegion  Add(unsigned int width, unsigned int height, const unsigned char *rgba);
+    // the page textures
+    const std::vector<Texture2D> &Pages() const { return this->pages; }
+    // current packing statistics
+    AtlasStats   Stats() const;
+    // the streamer the pages are uploaded through, e.g. for its byte counters
+    const TextureStreamer &Streamer() const { return this->streamer; }
+    // deletes all pages
+    void         Clear();
+private:
+    std::vector<Texture2D>     pages;
+    TextureStreamer            streamer;
+    std::vector<SkylinePacker> packers;
+    unsigned int               images;
+    std::size_t                usedPixels;
+    // creates a new, empty page and its packer
+    void addPage();
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "texture_streamer.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+namespace
+{
+    unsigned int bytesPerPixel(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_RED:  return 1;
+        case GL_RG:   return 2;
+        case GL_RGB:
+        case GL_BGR:  return 3;
+        default:      return 4;
+        }
+    }
+}
+
+TextureStreamer::TextureStreamer(GLsizeiptr regionSize)
+    : regionSize(regionSize), ring(nullptr), texture(0), x(0), y(0), width(0), height(0), format(GL_RGBA), pitch(0),
+      frame(0), frameBytes(0), lastFrameBytes(0), peakFrameBytes(0), totalBytes(0)
+{
+
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    this->Clear();
+}
+
+unsigned char *TextureStreamer::Begin(Texture2DView texture, unsigned int x, unsigned int y, unsigned int width, unsigned int height, GLenum format)
+{
+    if (texture.ID == 0 || x + width > texture.Width || y + height > texture.Height)
+    {
+        std::cout << "ERROR::TEXTURE_STREAMER: Update of " << width << "x" << height << " at " << x << "," << y
+            << " is outside the " << texture.Width << "x" << texture.Height << " texture" << std::endl;
+        return nullptr;
+    }
+    std::size_t pitch = (static_cast<std::size_t>(width) * bytesPerPixel(format) + 3) & ~static_cast<std::size_t>(3);
+    // keep every write 16-byte aligned inside the ring so rows stay aligned too
+    GLsizeiptr size = static_cast<GLsizeiptr>((pitch * height + 15) & ~static_cast<std::size_t>(15));
+    if (size > this->regionSize)
+        return nullptr;
+    if (this->ring == nullptr)
+        this->ring = new StreamBuffer(GL_PIXEL_UNPACK_BUFFER, this->regionSize);
+    unsigned char *data = static_cast<unsigned char*>(this->ring->Map(size));
+    if (data == nullptr)
+        return nullptr;
+    this->texture = texture.ID;
+    this->x = x;
+    this->y = y;
+    this->width = width;
+    this->height = height;
+    this->format = format;
+    this->pitch = pitch;
+    return data;
+}
+
+void TextureStreamer::End()
+{
+    GLintptr offset = this->ring->Unmap();
+    // with a buffer bound to GL_PIXEL_UNPACK_BUFFER the data pointer is an offset into it
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, this->ring->ID);
+    GLState::BindTexture(GL_TEXTURE_2D, this->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, this->x, this->y, this->width, this->height, this->format, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(offset));
+    // unbind again, every other texture upload passes client memory
+    GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    this->account(static_cast<std::size_t>(this->width) * bytesPerPixel(this->format) * this->height);
+}
+
+void TextureStreamer::Update(Texture2DView texture, unsigned int x, unsigned int y, unsigned int width, unsigned int height, GLenum format, const unsigned char *pixels)
+{
+    std::size_t rowBytes = static_cast<std::size_t>(width) * bytesPerPixel(format);
+    unsigned char *data = this->Begin(texture, x, y, width, height, format);
+    if (data != nullptr)
+    {
+        for (unsigned int row = 0; row < height; ++row)
+            std::memcpy(data + row * this->pitch, pixels + row * rowBytes, rowBytes);
+        this->End();
+        return;
+    }
+    if (texture.ID == 0 || x + width > texture.Width || y + height > texture.Height)
+        return;
+    // too large for a ring region: synchronous upload from client memory, rows tightly packed
+    GLState::BindTexture(GL_TEXTURE_2D, texture.ID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    this->account(rowBytes * height);
+}
+
+std::size_t TextureStreamer::FrameBytes() const
+{
+    return this->frame == GLState::Frames() ? this->frameBytes : 0;
+}
+
+std::size_t TextureStreamer::LastFrameBytes() const
+{
+    if (this->frame == GLState::Frames())
+        return this->lastFrameBytes;
+    return this->frame + 1 == GLState::Frames() ? this->frameBytes : 0;
+}
+
+void TextureStreamer::Clear()
+{
+    delete this->ring;
+    this->ring = nullptr;
+}
+
+void TextureStreamer::account(std::size_t bytes)
+{
+    if (this->frame != GLState::Frames())
+    {
+        this->lastFrameBytes = this->LastFrameBytes();
+        this->frameBytes = 0;
+        this->frame = GLState::Frames();
+    }
+    this->frameBytes += bytes;
+    this->totalBytes += bytes;
+    this->peakFrameBytes = std::max(this->peakFrameBytes, this->frameBytes);
+}
\ No newline at end of file
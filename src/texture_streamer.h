@@ -0,0 +1,71 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "stream_buffer.h"
+#include "texture.h"
+
+
+// Streams texel data into existing textures through a ring of pixel
+// unpack buffers (a StreamBuffer on GL_PIXEL_UNPACK_BUFFER). Begin hands
+// out a pointer into mapped buffer memory, End issues glTexSubImage2D
+// from the buffer, which returns right away and lets the driver copy
+// the texels asynchronously; the ring's fences keep the CPU from
+// overwriting texels the GPU hasn't copied yet. Meant for textures that
+// change at runtime (atlas pages, CPU-drawn UI, video frames) and for
+// sub-rectangle updates of large textures.
+class TextureStreamer
+{
+public:
+    // constructor (no GL calls, the ring of REGION_COUNT * regionSize bytes is created on the first update)
+    TextureStreamer(GLsizeiptr regionSize = 4 * 1024 * 1024);
+    // destructor (call Clear first while the GL context is still alive)
+    ~TextureStreamer();
+    // starts updating the width x height rectangle at (x, y) of texture; returns where to write the rows, Pitch() bytes apart, or nullptr if the rectangle is out of bounds or larger than a ring region
+    unsigned char *Begin(Texture2DView texture, unsigned int x, unsigned int y, unsigned int width, unsigned int height, GLenum format = GL_RGBA);
+    // distance between rows of the update started by Begin (rows start 4-byte aligned, GL's default unpack alignment)
+    std::size_t    Pitch() const { return this->pitch; }
+    // issues the copy of the update started by Begin into its texture
+    void           End();
+    // Begin, copy of tightly packed pixels, End; rectangles too large for the ring are uploaded directly from pixels instead
+    void           Update(Texture2DView texture, unsigned int x, unsigned int y, unsigned int width, unsigned int height, GLenum format, const unsigned char *pixels);
+    // bytes of texels uploaded in the current frame, the last completed frame (frames as counted by GLState::EndFrame) and the busiest frame so far
+    std::size_t    FrameBytes() const;
+    std::size_t    LastFrameBytes() const;
+    std::size_t    PeakFrameBytes() const { return this->peakFrameBytes; }
+    // bytes of texels uploaded since construction
+    std::size_t    TotalBytes() const { return this->totalBytes; }
+    // the ring buffer, nullptr before the first update
+    const StreamBuffer *Ring() const { return this->ring; }
+    // deletes the ring buffer; the next update creates a new one
+    void           Clear();
+private:
+    GLsizeiptr    regionSize;
+    StreamBuffer *ring;
+    // the update between Begin and End
+    unsigned int  texture;
+    unsigned int  x, y, width, height;
+    GLenum        format;
+    std::size_t   pitch;
+    // byte counters, frame is the GLState frame frameBytes belongs to
+    unsigned int  frame;
+    std::size_t   frameBytes, lastFrameBytes, peakFrameBytes, totalBytes;
+    // adds bytes to the counters of the current frame
+    void account(std::size_t bytes);
+    // disable copying, the streamer owns its ring buffer
+    TextureStreamer(const TextureStreamer &) = delete;
+    TextureStreamer &operator=(const TextureStreamer &) = delete;
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "thread_pool.h"
+
+#include <utility>
+
+
+ThreadPool::ThreadPool(unsigned int threads)
+    : running(0), stopping(false)
+{
+    // leave a core to the main thread, which renders while the workers load; hardware_concurrency may report 0 (unknown)
+    if (threads == 0)
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+    for (unsigned int i = 0; i < threads; ++i)
+        this->workers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (std::thread &worker : this->workers)
+        worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->jobs.push_back(std::move(job));
+    }
+    this->wake.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idle.wait(lock, [this]() { return this->jobs.empty() && this->running == 0; });
+}
+
+void ThreadPool::run()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true)
+    {
+        this->wake.wait(lock, [this]() { return this->stopping || !this->jobs.empty(); });
+        if (this->jobs.empty())
+            return;
+        std::function<void()> job = std::move(this->jobs.front());
+        this->jobs.pop_front();
+        ++this->running;
+        lock.unlock();
+        job();
+        lock.lock();
+        if (--this->running == 0 && this->jobs.empty())
+            this->idle.notify_all();
+    }
+}
\ No newline at end of file
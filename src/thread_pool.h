@@ -0,0 +1,51 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// A fixed set of worker threads running submitted jobs in FIFO order.
+// Jobs must not touch GL: the context is only current on the main
+// thread, so workers produce CPU-side data (decoded images, file
+// contents) that the main thread hands to GL afterwards.
+class ThreadPool
+{
+public:
+    // constructor (starts threads workers; 0 picks one less than the hardware threads, at least one)
+    ThreadPool(unsigned int threads = 0);
+    // destructor (runs the jobs still queued, then joins the workers)
+    ~ThreadPool();
+    // queues job to run on one of the workers
+    void         Submit(std::function<void()> job);
+    // blocks until every job submitted so far has finished
+    void         Wait();
+    unsigned int Threads() const { return static_cast<unsigned int>(this->workers.size()); }
+private:
+    std::vector<std::thread>          workers;
+    std::mutex                        mutex;
+    std::condition_variable           wake;      // signaled when a job is queued or the pool stops
+    std::condition_variable           idle;      // signaled when the last running job finishes
+    std::deque<std::function<void()>> jobs;      // guarded by mutex
+    unsigned int                      running;   // guarded by mutex
+    bool                              stopping;  // guarded by mutex
+    // thread body, runs jobs until the pool stops and the queue is empty
+    void run();
+    // disable copying, the pool owns its threads
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+
+// Hands values from one writer thread to one reader thread without
+// locks or waiting. Of the three slots the writer owns one (Back), the
+// reader owns one (Front) and the third holds the latest published
+// value; Publish and Acquire swap their own slot with that one in a
+// single atomic exchange. The reader always sees the most recent
+// complete value, values published in between are skipped.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : ready(1), back(0), front(2) { }
+    // writer: the slot to fill before the next Publish
+    T       &Back() { return this->slots[this->back]; }
+    // writer: makes Back the latest value and hands out another slot as Back
+    void     Publish()
+    {
+        unsigned int previous = this->ready.exchange(this->back | FRESH, std::memory_order_acq_rel);
+        this->back = previous & INDEX;
+    }
+    // reader: switches Front to the latest value if one was published since the last call; returns true if it did
+    bool     Acquire()
+    {
+        if ((this->ready.load(std::memory_order_relaxed) & FRESH) == 0)
+            return false;
+        unsigned int latest = this->ready.exchange(this->front, std::memory_order_acq_rel);
+        this->front = latest & INDEX;
+        return true;
+    }
+    // reader: the value taken by the last successful Acquire
+    const T &Front() const { return this->slots[this->front]; }
+private:
+    // ready holds a slot index plus a flag telling whether it was published after the reader last looked
+    enum { INDEX = 3, FRESH = 4 };
+    T                         slots[3];
+    std::atomic<unsigned int> ready;
+    unsigned int              back;    // writer only
+    unsigned int              front;   // reader only
+};
+
+#endif
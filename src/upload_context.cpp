@@ -0,0 +1,138 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "upload_context.h"
+
+#include <iostream>
+
+// Instantiate static variables
+GLFWwindow                  *UploadContext::window = nullptr;
+std::thread                  UploadContext::thread;
+std::mutex                   UploadContext::mutex;
+std::condition_variable      UploadContext::wake;
+std::condition_variable      UploadContext::idle;
+std::deque<UploadContext::Job> UploadContext::queued;
+std::deque<UploadContext::Job> UploadContext::fenced;
+bool                         UploadContext::busy = false;
+bool                         UploadContext::stopping = false;
+unsigned int                 UploadContext::inFlight = 0;
+
+
+bool UploadContext::Start(GLFWwindow *shared)
+{
+    if (window != nullptr)
+        return true;
+    // same context hints as the main window (GLFW keeps them), just never shown
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(1, 1, "upload", nullptr, shared);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (window == nullptr)
+    {
+        std::cout << "ERROR::UPLOAD_CONTEXT: Failed to create shared context, uploading on the render thread" << std::endl;
+        return false;
+    }
+    stopping = false;
+    thread = std::thread(&UploadContext::run);
+    return true;
+}
+
+void UploadContext::Stop()
+{
+    if (window == nullptr)
+        return;
+    Finish();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+    glfwDestroyWindow(window);
+    window = nullptr;
+}
+
+void UploadContext::Submit(std::function<void()> upload, std::function<void()> publish)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back({ std::move(upload), std::move(publish), nullptr });
+    }
+    ++inFlight;
+    wake.notify_one();
+}
+
+void UploadContext::Poll()
+{
+    if (inFlight > 0)
+        publish(0);
+}
+
+void UploadContext::Finish()
+{
+    if (inFlight == 0)
+        return;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, []() { return queued.empty() && !busy; });
+    }
+    // every fence is flushed by now, so this waits for the GPU at most
+    publish(GL_TIMEOUT_IGNORED);
+}
+
+void UploadContext::run()
+{
+    // GL entry points are shared between contexts of the same pixel format, so glad needs no reload here
+    glfwMakeContextCurrent(window);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, []() { return stopping || !queued.empty(); });
+        if (queued.empty())
+            break;
+        Job job = std::move(queued.front());
+        queued.pop_front();
+        busy = true;
+        lock.unlock();
+        job.Upload();
+        job.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // without a flush the fence may never reach the GPU and the render thread would wait on it forever
+        glFlush();
+        lock.lock();
+        fenced.push_back(std::move(job));
+        busy = false;
+        if (queued.empty())
+            idle.notify_all();
+    }
+    lock.unlock();
+    glfwMakeContextCurrent(nullptr);
+}
+
+void UploadContext::publish(GLuint64 timeout)
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (fenced.empty())
+            return;
+        GLsync fence = fenced.front().Fence;
+        lock.unlock();
+        // jobs finish in submission order, so the first pending fence decides whether anything else is ready
+        GLenum status = glClientWaitSync(fence, 0, timeout);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return;
+        if (status == GL_WAIT_FAILED)
+            std::cout << "ERROR::UPLOAD_CONTEXT: Waiting for an upload fence failed" << std::endl;
+        glDeleteSync(fence);
+        lock.lock();
+        Job job = std::move(fenced.front());
+        fenced.pop_front();
+        lock.unlock();
+        --inFlight;
+        job.Publish();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef UPLOAD_CONTEXT_H
+#define UPLOAD_CONTEXT_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+
+// A static singleton owning a dedicated upload thread with its own GL
+// context: a hidden GLFW window sharing objects with the main window.
+// Uploads (glTexImage2D, glBufferData, ...) run there instead of
+// stalling the render thread. Each upload is followed by a fence; the
+// render thread polls the fences in Poll and only then runs the
+// upload's publish step, so a resource becomes visible to rendering
+// once its data is guaranteed to be complete. Upload jobs must use
+// plain GL calls, never GLState, whose cache mirrors the render
+// thread's context.
+class UploadContext
+{
+public:
+    // creates the shared context and starts the thread; call on the main thread once its context is current. Returns false if the context could not be created
+    static bool Start(GLFWwindow *shared);
+    // publishes every queued upload, then stops the thread and destroys the context
+    static void Stop();
+    // true between a successful Start and Stop
+    static bool Running() { return window != nullptr; }
+    // queues upload to run on the upload thread; publish runs on the render thread (in Poll) once the upload's fence signaled
+    static void Submit(std::function<void()> upload, std::function<void()> publish);
+    // call once per frame on the render thread: publishes the uploads that completed, without waiting for the others
+    static void Poll();
+    // blocks until every queued upload is complete and published
+    static void Finish();
+    // uploads submitted and not yet published
+    static unsigned int InFlight() { return inFlight; }
+private:
+    // private constructor, that is we do not want any actual upload context objects. Its members and functions should be publicly available (static).
+    UploadContext() { }
+    struct Job
+    {
+        std::function<void()> Upload;
+        std::function<void()> Publish;
+        GLsync                Fence;
+    };
+    static GLFWwindow             *window;
+    static std::thread             thread;
+    static std::mutex              mutex;
+    static std::condition_variable wake;      // signaled when a job is queued or the thread should stop
+    static std::condition_variable idle;      // signaled when the thread ran out of jobs
+    static std::deque<Job>         queued;    // waiting for the upload thread, guarded by mutex
+    static std::deque<Job>         fenced;    // uploaded, waiting for their fence, guarded by mutex
+    static bool                    busy;      // the upload thread is running a job, guarded by mutex
+    static bool                    stopping;  // guarded by mutex
+    static unsigned int            inFlight;  // render thread only
+    // thread body, runs uploads until stopped
+    static void run();
+    // publishes fenced jobs in order, waiting up to timeout nanoseconds for each fence
+    static void publish(GLuint64 timeout);
+};
+
+#endif
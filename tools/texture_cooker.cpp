@@ -0,0 +1,110 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+// Cooks an image into a .btex file (see src/cooked_texture.h): decodes
+// it once at build time, expands it to RGB or RGBA, optionally
+// premultiplies alpha and stores the full mip chain, so the game only
+// has to map the file and upload it.
+//
+//   texture_cooker [--premultiply] input.png output.btex
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cooked_texture.h"
+#include "stb_image.h"
+
+
+namespace
+{
+    // distance between rows of a level, padded to GL's default unpack alignment
+    std::size_t pitch(unsigned int width, unsigned int channels)
+    {
+        return CookedTexture::RowPitch(width, channels);
+    }
+
+    // halves a level with a 2x2 box filter (a 1 pixel wide or high level only shrinks in the other direction)
+    std::vector<unsigned char> downsample(const std::vector<unsigned char> &source, unsigned int width, unsigned int height, unsigned int channels)
+    {
+        unsigned int nextWidth = std::max(1u, width / 2), nextHeight = std::max(1u, height / 2);
+        std::vector<unsigned char> level(pitch(nextWidth, channels) * nextHeight);
+        for (unsigned int y = 0; y < nextHeight; ++y)
+        {
+            for (unsigned int x = 0; x < nextWidth; ++x)
+            {
+                unsigned int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+                unsigned int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+                for (unsigned int c = 0; c < channels; ++c)
+                {
+                    unsigned int sum = source[y0 * pitch(width, channels) + x0 * channels + c] + source[y0 * pitch(width, channels) + x1 * channels + c]
+                        + source[y1 * pitch(width, channels) + x0 * channels + c] + source[y1 * pitch(width, channels) + x1 * channels + c];
+                    level[y * pitch(nextWidth, channels) + x * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+        return level;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool premultiply = false;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--premultiply") == 0)
+            premultiply = true;
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.size() != 2)
+    {
+        std::cout << "usage: texture_cooker [--premultiply] input.png output.btex" << std::endl;
+        return 1;
+    }
+
+    int width, height, nrChannels;
+    if (!stbi_info(files[0].c_str(), &width, &height, &nrChannels))
+    {
+        std::cout << "ERROR::TEXTURE_COOKER: Failed to load " << files[0] << std::endl;
+        return 1;
+    }
+    // grey and grey-alpha images are expanded, GL gets RGB or RGBA only
+    unsigned int channels = (nrChannels == 2 || nrChannels == 4) ? 4 : 3;
+    unsigned char *data = stbi_load(files[0].c_str(), &width, &height, &nrChannels, channels);
+    if (data == nullptr)
+    {
+        std::cout << "ERROR::TEXTURE_COOKER: Failed to load " << files[0] << std::endl;
+        return 1;
+    }
+    std::vector<std::vector<unsigned char>> levels(1, std::vector<unsigned char>(pitch(width, channels) * height));
+    for (int y = 0; y < height; ++y)
+    {
+        unsigned char *row = levels[0].data() + y * pitch(width, channels);
+        std::memcpy(row, data + static_cast<std::size_t>(y) * width * channels, static_cast<std::size_t>(width) * channels);
+        if (premultiply && channels == 4)
+            for (int x = 0; x < width; ++x)
+                for (int c = 0; c < 3; ++c)
+                    row[x * 4 + c] = static_cast<unsigned char>((row[x * 4 + c] * row[x * 4 + 3] + 127) / 255);
+    }
+    stbi_image_free(data);
+
+    // the full chain down to 1x1, filtered from the (premultiplied) level above
+    for (unsigned int w = width, h = height; w > 1 || h > 1; w = std::max(1u, w / 2), h = std::max(1u, h / 2))
+        levels.push_back(downsample(levels.back(), w, h, channels));
+
+    BtexHeader header = { BTEX_MAGIC, BTEX_VERSION, static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), channels,
+        static_cast<std::uint32_t>(levels.size()), premultiply && channels == 4 ? BTEX_PREMULTIPLIED : 0u, 0 };
+    if (!CookedTexture::Write(files[1], header, levels))
+        return 1;
+    std::cout << "Cooked " << files[0] << " -> " << files[1] << " (" << width << "x" << height << ", " << channels << " channels, "
+        << levels.size() << " levels" << (header.Flags & BTEX_PREMULTIPLIED ? ", premultiplied" : "") << ")" << std::endl;
+    return 0;
+}
\ No newline at end of file